@@ -0,0 +1,23 @@
+#version 450 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#endif
+// 深度预通道：顶点程序。只读取位置，没有片元着色器，只写入深度。
+
+// 统一缓冲绑定0中的变换统一变量
+#include "include/transform.glsl"
+
+#include "include/draw_records.glsl"
+
+layout(location=0) in vec3 inPosition;
+layout(location=15) in uint drawIndex;		// 绘制队列的记录序号
+
+// 与 pbr.vert 使用完全相同的变换表达式并声明 invariant，
+// 两个通道得到逐位相同的深度，PBR 通道才能以 GL_EQUAL 通过深度测试
+invariant gl_Position;
+
+void main()
+{
+	const mat4 model = drawRecords[drawIndex].model;
+	gl_Position = viewProjectionMatrix * sceneRotationMatrix *model* vec4(inPosition, 1.0);
+}
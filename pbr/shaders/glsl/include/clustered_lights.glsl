@@ -0,0 +1,44 @@
+// 分簇前向渲染：局部光源（点光源与聚光灯）与视锥体素（froxel）网格
+// 视锥体在屏幕上按 clusterGrid.xy 划分，在深度上按指数划分为 clusterGrid.z 层；
+// cluster.comp 为每个簇写入相交的光源索引，pbr.frag 只遍历片元所在簇的光源
+
+const uint ClusterMaxLights = 128u;		// 每个簇记录的光源数量上限，需与 Path.h 中的 gClusterMaxLights 一致
+
+// 与 Renderer.cpp 中的 LocalLightSB 一致
+struct LocalLight {
+	vec4 positionRange;			// xyz 为世界空间位置，w 为影响半径
+	vec4 radianceCosInner;		// xyz 为辐射能量，w 为聚光灯内锥角余弦
+	vec4 directionCosOuter;		// xyz 为聚光灯方向，w 为外锥角余弦（点光源的内外余弦小于 -1，任何方向的系数都为 1）
+};
+
+// 与 Renderer.cpp 中的 ClusterUB 一致
+layout(std140, binding=2) uniform ClusterUniforms
+{
+	mat4 clusterViewMatrix;				// 世界空间到视图空间（不含场景旋转）
+	mat4 clusterProjectionMatrix;		// 投影矩阵（含当前帧抖动）
+	mat4 clusterInverseProjectionMatrix;
+	uvec4 clusterGrid;					// xyz 为簇网格尺寸，w 为局部光源数量
+	vec4 clusterDepth;					// 近平面、远平面、深度分层的比例与偏移：slice = log(depth) * z + w
+};
+
+layout(std430, binding=1) restrict readonly buffer LocalLights
+{
+	LocalLight localLights[];
+};
+
+// 视图空间深度（正值）所在的深度层
+uint clusterSlice(float viewDepth)
+{
+	float slice = log(max(viewDepth, clusterDepth.x)) * clusterDepth.z + clusterDepth.w;
+	return uint(clamp(slice, 0.0, float(clusterGrid.z) - 1.0));
+}
+
+// 世界空间位置所在的簇，视锥体之外的位置钳制到边界的簇
+uint clusterIndex(vec3 worldPosition)
+{
+	vec4 viewPosition = clusterViewMatrix * vec4(worldPosition, 1.0);
+	vec4 clipPosition = clusterProjectionMatrix * viewPosition;
+	vec2 tile = (clipPosition.xy / clipPosition.w * 0.5 + 0.5) * vec2(clusterGrid.xy);
+	uvec2 xy = uvec2(clamp(tile, vec2(0.0), vec2(clusterGrid.xy) - 1.0));
+	return (clusterSlice(-viewPosition.z) * clusterGrid.y + xy.y) * clusterGrid.x + xy.x;
+}
@@ -0,0 +1,16 @@
+// 绘制队列的逐绘制记录，与 DrawQueue.h 中的 DrawRecord 一致（std430，每条 80 字节）。
+// 顶点程序的记录序号来自属性 15：除数为 1 的序号缓冲区，值为 baseInstance + gl_InstanceID，
+// 多重绘制的每条命令以 baseInstance 指向自己的第一条记录
+
+struct DrawRecord {
+	mat4 model;
+	uint firstIndex;		// 网格在网格缓冲区池中的第一个索引
+	int baseVertex;			// 网格在网格缓冲区池中的第一个顶点
+	uint padding0;
+	uint padding1;
+};
+
+layout(std430, binding=5) restrict readonly buffer DrawRecords
+{
+	DrawRecord drawRecords[];
+};
@@ -0,0 +1,17 @@
+// GGX 重要性采样，供 spmap、spbrdf 共用
+// 使用前需要声明 TwoPI
+
+// 重要性采样GGX法线分布函数，对于给定的粗糙度值。
+// 返回Li和Lo之间的归一化半向量。
+// 参考连接：http://blog.tobias-franke.eu/2014/03/30/notes_on_importance_sampling.html
+vec3 sampleGGX(float u1, float u2, float roughness)
+{
+    float alpha = roughness * roughness;
+
+    float cosTheta = sqrt((1.0 - u2) / (1.0 + (alpha * alpha - 1.0) * u2));
+    float sinTheta = sqrt(1.0 - cosTheta * cosTheta); // 三角恒等式
+    float phi = TwoPI * u1;
+
+    // 返回笛卡尔坐标系中的向量。
+    return vec3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta);
+}
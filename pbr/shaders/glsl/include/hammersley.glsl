@@ -0,0 +1,20 @@
+// 哈默斯利序列（Hammersley），供 irmap、spmap、spbrdf 的准蒙特卡洛积分共用
+// 使用前需要声明样本数量 NumSamples
+
+// 计算范德科尔普特基数逆序
+// 参考: http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
+float radicalInverse_VdC(uint bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 2.3283064365386963e-10; // / 0x100000000
+}
+
+// 从SampleNum样本点集合中采样第i个点
+vec2 sampleHammersley(uint i)
+{
+	return vec2(float(i) / float(NumSamples), radicalInverse_VdC(i));
+}
@@ -0,0 +1,45 @@
+// 方向光的级联阴影：阴影图数组与矩阵按场景光源排列，第 light 个启用光源的第 cascade 级位于 shadowLightLayers[light] + cascade 层，
+// 开关其他光源时缓存的阴影图仍属于原来的光源。
+// 矩阵为该层实际渲染时使用的矩阵，轮转更新期间尚未重新渲染的级联仍与其缓存内容一致。
+// 依赖 clustered_lights.glsl 中的 clusterViewMatrix 求片元的视距
+
+const int MaxShadowCascades = 4;		// 需不小于 Path.h 中的 gShadowCascades
+
+// 与 Renderer.cpp 中的 ShadowUB 一致
+layout(std140, binding=3) uniform ShadowUniforms
+{
+	mat4 shadowMatrices[MaxLights * MaxShadowCascades];	// 世界空间到阴影图纹理坐标与深度（[0,1]）
+	vec4 cascadeSplits;				// 每一级的最远视距
+	vec4 cascadeTexelSizes;			// 每一级一个阴影图纹素在世界空间中的大小
+	uvec4 shadowParams;				// x 为级联数量，0 表示不使用阴影
+	uvec4 shadowLightLayers;		// 第 light 个启用光源的起始层
+};
+
+layout(binding=7) uniform sampler2DArrayShadow shadowTexture;
+
+// 第 light 个启用光源在 worldPosition 处的可见度，N 为单位法线。沿法线偏移一个半纹素以上，减少自阴影
+float directionalShadow(int light, vec3 worldPosition, vec3 N)
+{
+	const uint numCascades = shadowParams.x;
+	if(numCascades == 0u) {
+		return 1.0;
+	}
+
+	const float viewDepth = -(clusterViewMatrix * vec4(worldPosition, 1.0)).z;
+	uint cascade = 0u;
+	while(cascade < numCascades && viewDepth > cascadeSplits[cascade]) {
+		++cascade;
+	}
+	if(cascade == numCascades) {
+		return 1.0;
+	}
+
+	const uint layer = shadowLightLayers[light] + cascade;
+	const vec3 offsetPosition = worldPosition + N * (1.5 * cascadeTexelSizes[cascade]);
+	const vec3 shadowPosition = (shadowMatrices[layer] * vec4(offsetPosition, 1.0)).xyz;
+	if(any(lessThan(shadowPosition.xy, vec2(0.0))) || any(greaterThan(shadowPosition.xy, vec2(1.0)))) {
+		return 1.0;
+	}
+	// 深度比较纹理的线性过滤即 2x2 PCF
+	return texture(shadowTexture, vec4(shadowPosition.xy, float(layer), shadowPosition.z));
+}
@@ -0,0 +1,19 @@
+// 切线空间与世界空间之间的转换，供 irmap、spmap 共用
+// 使用前需要声明 Epsilon
+
+// 计算正交基，用于从切线/着色空间转换到世界空间
+void computeBasisVectors(const vec3 N, out vec3 S, out vec3 T)
+{
+	// 无分支选择非退化T
+	T = cross(N, vec3(0.0, 1.0, 0.0));
+	T = mix(cross(N, vec3(1.0, 0.0, 0.0)), T, step(Epsilon, dot(T, T)));
+
+	T = normalize(T);
+	S = normalize(cross(N, T));
+}
+
+// 将点从切线/着色空间转换到世界空间
+vec3 tangentToWorld(const vec3 v, const vec3 N, const vec3 S, const vec3 T)
+{
+	return S * v.x + T * v.y + N * v.z;
+}
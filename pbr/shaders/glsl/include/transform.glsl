@@ -0,0 +1,20 @@
+// 变换统一缓冲区，与 Renderer.cpp 中的 TransformUB 一致
+// 上一帧的矩阵与两帧的投影抖动用于计算 TAA 的运动向量；MSAA 模式下抖动为 0
+layout(std140, binding=0) uniform TransformUniforms
+{
+	mat4 viewProjectionMatrix;			// 视图投影矩阵（含当前帧抖动）
+	mat4 skyProjectionMatrix;			// 天空投影矩阵（含当前帧抖动）
+	mat4 sceneRotationMatrix;			// 场景旋转矩阵
+	mat4 prevViewProjectionMatrix;		// 上一帧的视图投影矩阵（含上一帧抖动）
+	mat4 prevSkyProjectionMatrix;		// 上一帧的天空投影矩阵（含上一帧抖动）
+	mat4 prevSceneRotationMatrix;		// 上一帧的场景旋转矩阵
+	vec4 jitter;						// xy 为当前帧抖动，zw 为上一帧抖动（NDC 单位）
+};
+
+// 由两帧的裁剪空间位置计算屏幕空间运动向量（纹理坐标单位），去除抖动以免静止画面产生运动
+vec2 computeVelocity(vec4 currClip, vec4 prevClip)
+{
+	vec2 curr = currClip.xy / currClip.w - jitter.xy;
+	vec2 prev = prevClip.xy / prevClip.w - jitter.zw;
+	return (curr - prev) * 0.5;
+}
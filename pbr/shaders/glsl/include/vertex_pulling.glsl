@@ -0,0 +1,49 @@
+// 顶点拉取：从网格缓冲区池的 SSBO 中按 gl_VertexID 读取并解码压缩顶点
+// 布局与 Buffer.cpp 中的 PackedVertex 一致，每个顶点 6 个 uint（24 字节）：
+//   [0..2] 位置（float）
+//   [3]    法线，八面体映射后的 snorm16x2
+//   [4]    切线，八面体映射后的 unorm16 + unorm15，最高位为副切线的符号
+//   [5]    纹理坐标，half2
+// glDrawElementsBaseVertex 的 basevertex 已包含在 gl_VertexID 中，索引缓冲区仍由硬件读取以保留顶点缓存
+
+const uint PackedVertexWords = 6;
+
+layout(std430, binding=0) restrict readonly buffer PackedVertices
+{
+	uint packedVertices[];
+};
+
+struct PulledVertex {
+	vec3 position;
+	vec3 normal;
+	vec3 tangent;
+	vec3 bitangent;
+	vec2 texcoord;
+};
+
+// 八面体映射的逆变换，输入范围 [-1, 1]
+vec3 decodeOctahedron(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	if(v.z < 0.0) {
+		v.xy = (1.0 - abs(v.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(v.xy, vec2(0.0)));
+	}
+	return normalize(v);
+}
+
+PulledVertex pullVertex(uint vertexId)
+{
+	const uint base = vertexId * PackedVertexWords;
+
+	PulledVertex v;
+	v.position = uintBitsToFloat(uvec3(packedVertices[base + 0], packedVertices[base + 1], packedVertices[base + 2]));
+	v.normal = decodeOctahedron(unpackSnorm2x16(packedVertices[base + 3]));
+
+	const uint t = packedVertices[base + 4];
+	const vec2 tangentOct = vec2(float(t & 0xFFFFu) / 65535.0, float((t >> 16) & 0x7FFFu) / 32767.0) * 2.0 - 1.0;
+	v.tangent = decodeOctahedron(tangentOct);
+	v.bitangent = cross(v.normal, v.tangent) * ((t & 0x80000000u) != 0u ? -1.0 : 1.0);
+
+	v.texcoord = unpackHalf2x16(packedVertices[base + 5]);
+	return v;
+}
@@ -0,0 +1,14 @@
+// 预计算着色器的工作组大小
+// SPIR-V 路径由特化常量 2/3 指定，GLSL 路径由 Shader 注入的 GROUP_SIZE_X/Y 宏指定
+#ifndef GROUP_SIZE_X
+#define GROUP_SIZE_X 32
+#endif
+#ifndef GROUP_SIZE_Y
+#define GROUP_SIZE_Y 32
+#endif
+
+#ifdef GL_SPIRV
+layout(local_size_x_id=2, local_size_y_id=3, local_size_z=1) in;
+#else
+layout(local_size_x=GROUP_SIZE_X, local_size_y=GROUP_SIZE_Y, local_size_z=1) in;
+#endif
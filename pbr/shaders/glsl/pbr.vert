@@ -1,19 +1,32 @@
 #version 450 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#endif
 
 // 基于物理的着色模型：顶点程序
-layout(location=0) in vec3 position;
-layout(location=1) in vec3 normal;
-layout(location=2) in vec3 tangent;
-layout(location=3) in vec3 bitangent;
-layout(location=4) in vec2 texcoord;
+
+// 着色器变体参数：VERTEX_PULLING 为 1 时从 SSBO 拉取压缩顶点，否则使用 VAO 提供的顶点属性
+#ifndef VERTEX_PULLING
+#define VERTEX_PULLING 0
+#endif
+#ifdef GL_SPIRV
+layout(constant_id=6) const int VertexPulling = VERTEX_PULLING;
+#else
+const int VertexPulling = VERTEX_PULLING;
+#endif
+
+layout(location=0) in vec3 inPosition;
+layout(location=1) in vec3 inNormal;
+layout(location=2) in vec3 inTangent;
+layout(location=3) in vec3 inBitangent;
+layout(location=4) in vec2 inTexcoord;
+layout(location=15) in uint drawIndex;		// 绘制队列的记录序号
+
+#include "include/vertex_pulling.glsl"
 
 // 统一缓冲对象，用于变换矩阵
-layout(std140, binding=0) uniform TransformUniforms
-{
-	mat4 viewProjectionMatrix;		// 视图投影矩阵
-	mat4 skyProjectionMatrix;		// 天空投影矩阵
-	mat4 sceneRotationMatrix;		// 场景旋转矩阵
-};
+#include "include/transform.glsl"
+#include "include/draw_records.glsl"
 
 // 输出顶点数据
 layout(location=0) out Vertex
@@ -23,12 +36,36 @@ layout(location=0) out Vertex
 	mat3 tangentBasis;		 // 输出切线基（用于法线贴图）
 } vout;
 
-uniform mat4 model;
+// 当前帧与上一帧的裁剪空间位置，用于计算运动向量
+layout(location=5) out vec4 currClipPosition;
+layout(location=6) out vec4 prevClipPosition;
+
+// 渲染所用的世界空间位置（含模型矩阵），用于局部光源的衰减与簇的查找
+layout(location=7) out vec3 worldPosition;
+
 //uniform mat4 view;
 //uniform mat4 projection;
 
+// 与 depth.vert 的深度预通道保持逐位相同的位置，使 GL_EQUAL 深度测试成立
+invariant gl_Position;
+
 void main()
 {
+	const mat4 model = drawRecords[drawIndex].model;
+	vec3 position = inPosition;
+	vec3 normal = inNormal;
+	vec3 tangent = inTangent;
+	vec3 bitangent = inBitangent;
+	vec2 texcoord = inTexcoord;
+	if(VertexPulling != 0) {
+		const PulledVertex v = pullVertex(uint(gl_VertexID));
+		position  = v.position;
+		normal    = v.normal;
+		tangent   = v.tangent;
+		bitangent = v.bitangent;
+		texcoord  = v.texcoord;
+	}
+
 	// 计算变换后的顶点位置（不包括投影变换）
 	vout.position = vec3(sceneRotationMatrix * vec4(position, 1.0));
 
@@ -40,4 +77,9 @@ void main()
 
 	// 计算顶点的最终位置，包括视图投影变换
 	gl_Position = viewProjectionMatrix * sceneRotationMatrix *model* vec4(position, 1.0);
+
+	worldPosition = vec3(sceneRotationMatrix * model * vec4(position, 1.0));
+
+	currClipPosition = gl_Position;
+	prevClipPosition = prevViewProjectionMatrix * prevSceneRotationMatrix * model * vec4(position, 1.0);
 }
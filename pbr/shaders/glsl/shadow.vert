@@ -0,0 +1,19 @@
+#version 450 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#endif
+// 级联阴影：顶点程序。从网格缓冲区池拉取位置，没有片元着色器，只写入深度。
+
+#include "include/vertex_pulling.glsl"
+#include "include/draw_records.glsl"
+
+layout(location=15) in uint drawIndex;		// 绘制队列的记录序号
+
+// 光源的裁剪空间 * 场景旋转，由 Renderer 对每一级计算；模型矩阵来自绘制记录
+layout(location=0) uniform mat4 sceneToShadow;
+
+void main()
+{
+	const PulledVertex v = pullVertex(uint(gl_VertexID));
+	gl_Position = sceneToShadow * drawRecords[drawIndex].model * vec4(v.position, 1.0);
+}
@@ -1,14 +1,23 @@
 #version 450 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#endif
 
 // 环境天空盒：片段着色器。
 layout(location=0) in vec3 localPosition;				// 输入属性
+layout(location=1) in vec4 currClipPosition;
+layout(location=2) in vec4 prevClipPosition;
 layout(location=0) out vec4 color;						// 输出颜色
+layout(location=1) out vec2 velocity;					// TAA 的运动向量
 layout(binding=0) uniform samplerCube envTexture;		// 环境贴图采样器
 
+#include "include/transform.glsl"
+
 void main()
 {
     // 标准化环境向量
     vec3 envVector = normalize(localPosition);
     // 从环境贴图中获取颜色
     color = textureLod(envTexture, envVector, 0);
+    velocity = computeVelocity(currClipPosition, prevClipPosition);
 }
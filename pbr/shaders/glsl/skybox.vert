@@ -1,21 +1,26 @@
 #version 450 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#endif
 // 环境天空盒：顶点程序。
 
 // 统一缓冲绑定0中的变换统一变量
-layout(std140, binding=0) uniform TransformUniforms
-{
-    mat4 viewProjectionMatrix;   // 视图投影矩阵
-    mat4 skyProjectionMatrix;    // 天空投影矩阵
-    mat4 sceneRotationMatrix;    // 场景旋转矩阵
-};
+#include "include/transform.glsl"
 
 layout(location=0) in vec3 position;
 layout(location=0) out vec3 localPosition;
+layout(location=1) out vec4 currClipPosition;
+layout(location=2) out vec4 prevClipPosition;
 
 void main()
 {
     // 将本地位置设置为顶点坐标的XYZ分量
     localPosition = position.xyz;
-    // 计算顶点在天空盒中的位置
-    gl_Position = skyProjectionMatrix * vec4(position, 1.0);
+    // 计算顶点在天空盒中的位置。z 取 w，透视除法后深度固定在远平面，
+    // 天空盒在不透明几何之后以 GL_LEQUAL 绘制，只有未被遮挡的像素运行片元着色器
+    gl_Position = (skyProjectionMatrix * vec4(position, 1.0)).xyww;
+
+    // 天空盒只随视角旋转，运动向量由两帧的天空投影矩阵得到
+    currClipPosition = gl_Position;
+    prevClipPosition = (prevSkyProjectionMatrix * vec4(position, 1.0)).xyww;
 }
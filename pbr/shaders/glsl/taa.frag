@@ -0,0 +1,65 @@
+#version 450 core
+
+// 时间性抗锯齿（TAA）与放大：当前帧以抖动投影、可能较低的内部分辨率渲染，
+// 按运动向量重投影上一帧的输出，在当前帧 3x3 邻域的颜色范围内约束后混合，输出显示分辨率的结果。
+// 参考："High Quality Temporal Supersampling", Brian Karis, SIGGRAPH 2014
+
+layout(location=0) in  vec2 screenPosition;
+layout(binding=0) uniform sampler2D sceneColor;			// 当前帧颜色（内部分辨率）
+layout(binding=1) uniform sampler2D velocityTexture;		// 运动向量（内部分辨率，纹理坐标单位）
+layout(binding=2) uniform sampler2D historyColor;		// 上一帧的 TAA 输出（显示分辨率）
+
+layout(location=0) uniform vec2 jitter;					// 当前帧抖动（纹理坐标单位）
+layout(location=1) uniform float historyWeight;			// 历史帧的权重，历史无效时为 0
+layout(location=2) uniform vec2 viewportScale;			// 动态分辨率下视口在场景目标中所占的比例
+
+layout(location=0) out vec4 outColor;
+
+vec3 rgbToYCoCg(vec3 c)
+{
+	return vec3(dot(c, vec3(0.25, 0.5, 0.25)), dot(c, vec3(0.5, 0.0, -0.5)), dot(c, vec3(-0.25, 0.5, -0.25)));
+}
+
+vec3 yCoCgToRgb(vec3 c)
+{
+	return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// 按亮度的倒数加权，抑制高亮像素在混合时的闪烁
+float lumaWeight(vec3 yCoCg)
+{
+	return 1.0 / (1.0 + max(yCoCg.x, 0.0));
+}
+
+void main()
+{
+	// 抖动后的渲染结果在 uv 处对应未抖动画面的 uv - jitter，因此在 uv + jitter 处采样
+	const vec2 uv = screenPosition;
+	const vec3 current = rgbToYCoCg(texture(sceneColor, (uv + jitter) * viewportScale).rgb);
+
+	// 当前帧 3x3 邻域的颜色范围，只在视口区域内取样
+	const ivec2 size = ivec2(vec2(textureSize(sceneColor, 0)) * viewportScale + 0.5);
+	const ivec2 center = clamp(ivec2(uv * vec2(size)), ivec2(0), size - 1);
+	vec3 minColor = current;
+	vec3 maxColor = current;
+	for(int y = -1; y <= 1; ++y) {
+		for(int x = -1; x <= 1; ++x) {
+			const vec3 c = rgbToYCoCg(texelFetch(sceneColor, clamp(center + ivec2(x, y), ivec2(0), size - 1), 0).rgb);
+			minColor = min(minColor, c);
+			maxColor = max(maxColor, c);
+		}
+	}
+
+	// 重投影历史帧；离开屏幕的像素没有可用的历史
+	const vec2 historyUV = uv - texelFetch(velocityTexture, center, 0).xy;
+	float weight = historyWeight;
+	if(any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0)))) {
+		weight = 0.0;
+	}
+	// 第一帧的历史目标内容未定义，不能参与计算（0 * NaN 仍为 NaN）
+	const vec3 history = weight > 0.0 ? clamp(rgbToYCoCg(texture(historyColor, historyUV).rgb), minColor, maxColor) : current;
+
+	const float wc = (1.0 - weight) * lumaWeight(current);
+	const float wh = weight * lumaWeight(history);
+	outColor = vec4(yCoCgToRgb((current * wc + history * wh) / (wc + wh)), 1.0);
+}
@@ -6,22 +6,50 @@ const float gamma     = 2.2;
 const float exposure  = 1.0;
 const float pureWhite = 1.0;
 
+// 着色器变体参数：MSAA_SAMPLES 大于 0 时为融合解析，直接从多采样目标逐样本读取。
+// 采样器类型不能由特化常量决定，这个变体总是从 GLSL 源码编译
+#ifndef MSAA_SAMPLES
+#define MSAA_SAMPLES 0
+#endif
+
 layout(location=0) in  vec2 screenPosition;
+#if MSAA_SAMPLES > 0
+layout(binding=0) uniform sampler2DMS sceneColor;
+#else
 layout(binding=0) uniform sampler2D sceneColor;
+#endif
+layout(location=0) uniform vec2 uvScale;		// 动态分辨率下视口在场景目标中所占的比例
 
 layout(location=0) out vec4 outColor;
 
-void main()
+// Reinhard色调映射算子。
+// 参考："Photographic Tone Reproduction for Digital Images", eq. 4
+vec3 tonemap(vec3 color)
 {
-    vec3 color = texture(sceneColor, screenPosition).rgb * exposure;
-
-    // Reinhard色调映射算子。
-    // 参考："Photographic Tone Reproduction for Digital Images", eq. 4
     float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
     float mappedLuminance = (luminance * (1.0 + luminance / (pureWhite * pureWhite))) / (1.0 + luminance);
 
-    // 根据平均亮度比例缩放颜色。
-    vec3 mappedColor = (mappedLuminance / luminance) * color;
+    // 根据平均亮度比例缩放颜色。纯黑的样本直接返回，避免 0/0
+    return luminance > 0.0 ? (mappedLuminance / luminance) * color : vec3(0.0);
+}
+
+void main()
+{
+#if MSAA_SAMPLES > 0
+    // 自定义解析：先对每个样本做色调映射再平均，高对比度边缘不会被少数高亮样本主导。
+    // 动态分辨率下按最近的像素放大
+    ivec2 viewportSize = ivec2(vec2(textureSize(sceneColor)) * uvScale + 0.5);
+    ivec2 texel = min(ivec2(screenPosition * vec2(viewportSize)), viewportSize - 1);
+    vec3 mappedColor = vec3(0.0);
+    for(int i = 0; i < MSAA_SAMPLES; ++i) {
+        mappedColor += tonemap(texelFetch(sceneColor, texel, i).rgb * exposure);
+    }
+    mappedColor /= float(MSAA_SAMPLES);
+#else
+    // 只在视口区域内采样，并避免双线性过滤读到视口之外的像素
+    vec2 uv = min(screenPosition * uvScale, uvScale - 0.5 / vec2(textureSize(sceneColor, 0)));
+    vec3 mappedColor = tonemap(texture(sceneColor, uv).rgb * exposure);
+#endif
 
     // Gamma校正。
     outColor = vec4(pow(mappedColor, vec3(1.0 / gamma)), 1.0);
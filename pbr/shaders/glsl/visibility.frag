@@ -0,0 +1,14 @@
+#version 450 core
+// 可见性缓冲区：片元程序。只写入实例与三角形编号，着色由 visibility.comp 对每个像素完成一次。
+
+// 与 visibility.comp 一致：高 8 位为实例编号，低 24 位为三角形编号 + 1（0 表示没有几何）
+const uint VisibilityTriangleBits = 24u;
+
+layout(location=0) flat in uint instanceId;		// 本通道内的绘制记录序号，最多 256 个
+
+layout(location=0) out uint visibility;
+
+void main()
+{
+	visibility = (instanceId << VisibilityTriangleBits) | uint(gl_PrimitiveID + 1);
+}
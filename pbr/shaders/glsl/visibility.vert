@@ -0,0 +1,26 @@
+#version 450 core
+#ifdef GL_SPIRV
+#extension GL_GOOGLE_include_directive : require
+#endif
+// 可见性缓冲区：顶点程序。从网格缓冲区池拉取位置，只输出裁剪空间位置。
+
+#include "include/vertex_pulling.glsl"
+
+// 统一缓冲绑定0中的变换统一变量
+#include "include/transform.glsl"
+#include "include/draw_records.glsl"
+
+layout(location=15) in uint drawIndex;		// 绘制队列的记录序号
+
+// 本通道第一条绘制记录的序号，实例编号为记录序号与它之差
+layout(location=1) uniform uint firstRecord;
+
+layout(location=0) flat out uint instanceId;
+
+void main()
+{
+	const PulledVertex v = pullVertex(uint(gl_VertexID));
+	// 与 visibility.comp 重建顶点时的变换一致
+	gl_Position = viewProjectionMatrix * sceneRotationMatrix * drawRecords[drawIndex].model * vec4(v.position, 1.0);
+	instanceId = drawIndex - firstRecord;
+}
@@ -1,12 +1,19 @@
 #include <stdexcept>
+#include <format>
+#include <chrono>
+#include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
 #include "Application.h"
 #include "Renderer.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
 #include "Path.h"
 
 
 void Application::Init()
 {
+	JobSystem::Init(gJobWorkers);
+	FrameArena::Init(gFrameArenaSize);
 	mRenderer = new Renderer();
 	glfwWindowHint(GLFW_RESIZABLE, 0);
 	mWindow = mRenderer->Init();
@@ -16,23 +23,139 @@ void Application::Init()
 	glfwSetMouseButtonCallback(mWindow, Application::MouseButtonCallback);
 	glfwSetScrollCallback(mWindow, Application::MouseScrollCallback);
 	glfwSetKeyCallback(mWindow, Application::KeyCallback);
+	glfwSetWindowRefreshCallback(mWindow, Application::WindowRefreshCallback);
 }
 
 void Application::Load()
 {
 	mRenderer->Load();
+
+	// 上下文交给渲染线程；之后主线程只处理事件并发布快照
+	PublishSnapshot();
+	glfwMakeContextCurrent(nullptr);
+	mRenderThread = std::thread(&Application::RenderThread, this);
 }
 
 void Application::Run()
 {
+	// 渲染线程出错时结束并在主线程重新抛出
+	if (mRenderFailed.load(std::memory_order_acquire))
+	{
+		mIsRun = false;
+		StopRenderThread();
+		std::rethrow_exception(mRenderError);
+	}
 	mIsRun = !glfwWindowShouldClose(mWindow);
-	mRenderer->RenderFrame(mWindow, mViewSettings, mSceneSettings);
-	glfwPollEvents();
+
+	// 回调立即修改主线程的设置；快照最多按 gInputSampleRate 发布，两次采样之间的事件合并为一个快照
+	const double now = glfwGetTime();
+	if (mFrameDirty && now >= mNextSampleTime)
+	{
+		PublishSnapshot();
+		mNextSampleTime = now + 1.0 / gInputSampleRate;
+	}
+	// 有尚未发布的改变时最多等到下一次采样，否则一直等待事件；不受渲染帧时间影响
+	glfwWaitEventsTimeout(mFrameDirty ? glm::max(mNextSampleTime - now, 0.0) : gIdleWaitSeconds);
+}
+
+void Application::PublishSnapshot()
+{
+	FrameSnapshot& snapshot = mSnapshots.Back();
+	snapshot.view = mViewSettings;
+	snapshot.scene = mSceneSettings;
+	snapshot.renderPath = mRenderPath;
+	snapshot.inputTime = mInputTime;
+	mSnapshots.Publish();
+	mFrameDirty = false;
+	mInputTime = -1.0;
+	mRenderWake.release();
+}
+
+void Application::RenderThread()
+{
+	try
+	{
+		glfwMakeContextCurrent(mWindow);
+		bool idle = false;
+		double idleStart = 0.0;
+		while (!mStopRendering.load(std::memory_order_acquire))
+		{
+			// 帧节奏：先等待 GPU 追上，再取得最新的快照，输入尽可能新
+			mRenderer->WaitForNextFrame();
+			// 一次唤醒可能对应多次发布，只需要最新的快照
+			while (mRenderWake.try_acquire()) {}
+			const bool fresh = mSnapshots.Consume();
+			const FrameSnapshot& snapshot = mSnapshots.Front();
+			if (fresh && snapshot.renderPath != mRenderer->GetRenderPath())
+			{
+				mRenderer->SetRenderPath(snapshot.renderPath);
+			}
+
+			// 按需渲染：没有新快照、渲染器也不需要新的一帧时不渲染
+			if (!gOnDemandRendering || fresh || mRenderer->NeedsRedraw())
+			{
+				mPresentRequested.store(false, std::memory_order_relaxed);
+				mRenderer->RenderFrame(mWindow, snapshot.view, snapshot.scene, fresh ? snapshot.inputTime : -1.0);
+				if (idle && fresh && snapshot.inputTime >= 0.0)
+				{
+					// CPU 侧的延迟：从空闲后的第一个输入事件到新的一帧提交呈现
+					LOG_INFO(std::format("Woke after {:.1f} s idle, input to present {:.2f} ms",
+						snapshot.inputTime - idleStart, (glfwGetTime() - snapshot.inputTime) * 1000.0));
+				}
+				idle = false;
+				continue;
+			}
+
+			// 空闲：窗口需要刷新时重新呈现上一帧，然后等待新的快照；超时后再次询问渲染器（例如着色器文件被修改）
+			if (!idle)
+			{
+				idle = true;
+				idleStart = glfwGetTime();
+			}
+			if (mPresentRequested.exchange(false, std::memory_order_relaxed))
+			{
+				mRenderer->PresentLastFrame(mWindow);
+			}
+			mRenderWake.try_acquire_for(std::chrono::duration<double>(gIdleWaitSeconds));
+		}
+	}
+	catch (...)
+	{
+		mRenderError = std::current_exception();
+		mRenderFailed.store(true, std::memory_order_release);
+		glfwPostEmptyEvent();
+	}
+	glfwMakeContextCurrent(nullptr);
+}
+
+void Application::StopRenderThread()
+{
+	if (mRenderThread.joinable())
+	{
+		mStopRendering.store(true, std::memory_order_release);
+		mRenderWake.release();
+		mRenderThread.join();
+	}
+}
+
+void Application::MarkDirty()
+{
+	mFrameDirty = true;
+	if (mInputTime < 0.0)
+	{
+		mInputTime = glfwGetTime();
+	}
 }
 
 void Application::Clear()
 {
+	// 资源属于渲染线程的上下文，先结束渲染线程再在主线程释放
+	StopRenderThread();
+	glfwMakeContextCurrent(mWindow);
 	mRenderer->Clear();
+	JobSystem::ReportStats("Session");
+	JobSystem::Shutdown();
+	FrameArena::Delete();
 	//glfwTerminate();
 }
 
@@ -54,6 +177,11 @@ Application::Application()
 	mSceneSettings.lights[0].radiance = glm::vec3{1.0f};
 	mSceneSettings.lights[1].radiance = glm::vec3{1.0f};
 	mSceneSettings.lights[2].radiance = glm::vec3{1.0f};
+
+	if(gLocalLightCount > 0) 
+	{
+		mSceneSettings.localLights = Renderer::CreateLightField(gLocalLightCount, gLightFieldRadius, 1);
+	}
 }
 
 Application::~Application()
@@ -82,6 +210,7 @@ void Application::MousePositionCallback(GLFWwindow* window, double xpos, double
 
 		self->mPrevCursorX = xpos;
 		self->mPrevCursorY = ypos;
+		self->MarkDirty();
 	}
 }
 	
@@ -125,6 +254,7 @@ void Application::MouseScrollCallback(GLFWwindow* window, double xoffset, double
 {
 	Application* self = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
 	self->mViewSettings.distance += gZoomSpeed * float(-yoffset);
+	self->MarkDirty();
 }
 	
 void Application::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -145,11 +275,33 @@ void Application::KeyCallback(GLFWwindow* window, int key, int scancode, int act
 		case GLFW_KEY_F3:
 			light = &self->mSceneSettings.lights[2];
 			break;
+		case GLFW_KEY_F5:
+			self->mRenderPath = self->mRenderPath == RenderPath::Forward
+				? RenderPath::VisibilityBuffer : RenderPath::Forward;
+			self->MarkDirty();
+			break;
+		case GLFW_KEY_F6:
+			self->mRenderer->RequestRenderGraphDump();
+			self->MarkDirty();
+			break;
+		case GLFW_KEY_F7:
+			self->mRenderer->RequestTextureMemoryReport();
+			self->MarkDirty();
+			break;
 		}
 
 		if(light) 
 		{
 			light->enabled = !light->enabled;
+			self->MarkDirty();
 		}
 	}
 }
+
+void Application::WindowRefreshCallback(GLFWwindow* window)
+{
+	// 窗口被遮挡后恢复等情况：内容没有变化，重新呈现上一帧即可
+	Application* self = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
+	self->mPresentRequested.store(true, std::memory_order_relaxed);
+	self->mRenderWake.release();
+}
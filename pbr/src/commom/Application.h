@@ -3,7 +3,12 @@
 #define __APPLICATION_H__
 
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <semaphore>
+#include <exception>
 #include "RendererInterface.h"
+#include "TripleBuffer.h"
 
 class Application
 {
@@ -22,6 +27,17 @@ private:
 	static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 	static void MouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 	static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void WindowRefreshCallback(GLFWwindow* window);
+
+	// 视图或场景被输入改变，需要发布新的快照；记录发布前第一个输入事件的时间，用于测量延迟
+	void MarkDirty();
+
+	// 把当前的视图与场景设置复制为不可变的快照，交给渲染线程
+	void PublishSnapshot();
+
+	// 渲染线程：持有 GL 上下文，渲染最新的快照
+	void RenderThread();
+	void StopRenderThread();
 
 public:
 	RendererInterface* mRenderer;
@@ -42,6 +58,28 @@ private:
 		RotatingScene,
 	};
 	InputMode mInputMode;
+
+	RenderPath mRenderPath = RenderPath::Forward;
+
+	// 主线程发布给渲染线程的一帧输入
+	struct FrameSnapshot
+	{
+		ViewSettings view;
+		SceneSettings scene;
+		RenderPath renderPath = RenderPath::Forward;
+		double inputTime = -1.0;	// 快照包含的第一个输入事件的时间，-1 表示没有
+	};
+	TripleBuffer<FrameSnapshot> mSnapshots;
+	bool mFrameDirty = true;		// 设置在上一次发布之后被改变（只由主线程访问）
+	double mInputTime = -1.0;		// 尚未发布的第一个输入事件的时间
+	double mNextSampleTime = 0.0;	// 下一次可以发布快照的时间
+
+	std::thread mRenderThread;
+	std::counting_semaphore<> mRenderWake{ 0 };		// 新快照或刷新请求时唤醒空闲的渲染线程
+	std::atomic<bool> mStopRendering{ false };
+	std::atomic<bool> mPresentRequested{ false };	// 窗口需要刷新，但内容没有变化
+	std::atomic<bool> mRenderFailed{ false };
+	std::exception_ptr mRenderError;				// 渲染线程的异常，由主线程重新抛出
 };
 
 #endif // !__APPLICATION_H__
\ No newline at end of file
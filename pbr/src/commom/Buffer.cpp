@@ -1,6 +1,51 @@
 #include "Buffer.h"
 #include "Log.h"
 #include <GLFW/glfw3.h>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+	// ȡ·ѹ㣬 shaders/glsl/include/vertex_pulling.glsl
+	struct PackedVertex
+	{
+		float position[3];
+		uint32_t normal;		// ӳ䣬snorm16x2
+		uint32_t tangent;		// ӳ䣬unorm16 + unorm15λΪߵķ
+		uint32_t texcoord;		// half2
+	};
+	static_assert(sizeof(PackedVertex) == Buffer::mkPackedVertexSize);
+
+	// ӳ䣺λ -> [-1, 1]^2
+	glm::vec2 EncodeOctahedron(glm::vec3 v)
+	{
+		const float sum = glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+		v = sum > 0.0f ? v / sum : glm::vec3(0.0f, 0.0f, 1.0f);
+		glm::vec2 e(v.x, v.y);
+		if (v.z < 0.0f)
+		{
+			e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * glm::vec2(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return e;
+	}
+
+	PackedVertex PackVertex(const Mesh::Vertex& vertex)
+	{
+		PackedVertex packed;
+		packed.position[0] = vertex.position.x;
+		packed.position[1] = vertex.position.y;
+		packed.position[2] = vertex.position.z;
+		packed.normal = glm::packSnorm2x16(EncodeOctahedron(vertex.normal));
+
+		//  cross(normal, tangent) ؽֻ淽ķ
+		const glm::vec2 t = EncodeOctahedron(vertex.tangent) * 0.5f + 0.5f;
+		const bool flip = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f;
+		packed.tangent = static_cast<uint32_t>(glm::round(t.x * 65535.0f))
+			| static_cast<uint32_t>(glm::round(t.y * 32767.0f)) << 16
+			| (flip ? 0x80000000u : 0u);
+
+		packed.texcoord = glm::packHalf2x16(vertex.texcoord);
+		return packed;
+	}
+}
 
 MeshBuffer Buffer::CreateMeshBuffer(const std::shared_ptr<class Mesh>& mesh)
 {
@@ -63,6 +108,82 @@ void Buffer::DeleteMeshBuffer(MeshBuffer& buffer)
 	std::memset(&buffer, 0, sizeof(MeshBuffer));
 }
 
+MeshBuffer Buffer::CreatePositionBuffer(const std::shared_ptr<class Mesh>& mesh, GLuint indexBuffer, GLuint firstIndex)
+{
+	std::vector<glm::vec3> positions;
+	positions.reserve(mesh->mVertices.size());
+	for (const Mesh::Vertex& vertex : mesh->mVertices)
+	{
+		positions.push_back(vertex.position);
+	}
+
+	MeshBuffer buffer;
+	buffer.numElements = static_cast<GLuint>(mesh->mTriangle.size()) * 3;
+	buffer.firstIndex = firstIndex;
+	glCreateBuffers(1, &buffer.vbo);
+	glNamedBufferStorage(buffer.vbo, positions.size() * sizeof(glm::vec3), positions.data(), 0);
+
+	// λʹ 0 pbr.vert һ
+	glCreateVertexArrays(1, &buffer.vao);
+	glVertexArrayElementBuffer(buffer.vao, indexBuffer);
+	glVertexArrayVertexBuffer(buffer.vao, 0, buffer.vbo, 0, sizeof(glm::vec3));
+	glEnableVertexArrayAttrib(buffer.vao, 0);
+	glVertexArrayAttribFormat(buffer.vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(buffer.vao, 0, 0);
+	return buffer;
+}
+
+MeshArena Buffer::CreateMeshArena(GLuint vertexCapacity, GLuint indexCapacity)
+{
+	MeshArena arena;
+	arena.vertexCapacity = vertexCapacity;
+	arena.indexCapacity = indexCapacity;
+
+	glCreateBuffers(1, &arena.vertexBuffer);
+	glNamedBufferStorage(arena.vertexBuffer, vertexCapacity * mkPackedVertexSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &arena.indexBuffer);
+	glNamedBufferStorage(arena.indexBuffer, indexCapacity * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// ûκζԣȫɫ SSBO ȡ
+	glCreateVertexArrays(1, &arena.vao);
+	glVertexArrayElementBuffer(arena.vao, arena.indexBuffer);
+	return arena;
+}
+
+MeshBuffer Buffer::AllocateMeshBuffer(MeshArena& arena, const std::shared_ptr<class Mesh>& mesh)
+{
+	const GLuint numVertices = static_cast<GLuint>(mesh->mVertices.size());
+	const GLuint numIndices = static_cast<GLuint>(mesh->mTriangle.size()) * 3;
+	LOG_ASSERT(arena.numVertices + numVertices > arena.vertexCapacity || arena.numIndices + numIndices > arena.indexCapacity,
+		"Mesh arena out of capacity");
+
+	std::vector<PackedVertex> vertices;
+	vertices.reserve(numVertices);
+	for (const Mesh::Vertex& vertex : mesh->mVertices)
+	{
+		vertices.push_back(PackVertex(vertex));
+	}
+	glNamedBufferSubData(arena.vertexBuffer, arena.numVertices * mkPackedVertexSize, numVertices * mkPackedVertexSize, vertices.data());
+	// ڵľֲţʱͨ basevertex ƫ
+	glNamedBufferSubData(arena.indexBuffer, arena.numIndices * sizeof(uint32_t), numIndices * sizeof(uint32_t), mesh->mTriangle.data());
+
+	MeshBuffer buffer;
+	buffer.numElements = numIndices;
+	buffer.firstIndex = arena.numIndices;
+	buffer.baseVertex = static_cast<GLint>(arena.numVertices);
+	arena.numVertices += numVertices;
+	arena.numIndices += numIndices;
+	return buffer;
+}
+
+void Buffer::DeleteMeshArena(MeshArena& arena)
+{
+	if (arena.vao) glDeleteVertexArrays(1, &arena.vao);
+	if (arena.vertexBuffer) glDeleteBuffers(1, &arena.vertexBuffer);
+	if (arena.indexBuffer) glDeleteBuffers(1, &arena.indexBuffer);
+	arena = MeshArena();
+}
+
 FrameBuffer Buffer::CreateFrameBuffer(int width, int height, int samples, GLenum colorFormat, GLenum depthstencilFormat)
 {
 	FrameBuffer fb;
@@ -76,14 +197,19 @@ FrameBuffer Buffer::CreateFrameBuffer(int width, int height, int samples, GLenum
 	{
 		if (samples > 0) 
 		{
-			glCreateRenderbuffers(1, &fb.colorTarget);
-			glNamedRenderbufferStorageMultisample(fb.colorTarget, samples, colorFormat, width, height);
-			glNamedFramebufferRenderbuffer(fb.id, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, fb.colorTarget);
+			// ɫʹȾ壬Զʱͨ sampler2DMS ȡ
+			glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &fb.colorTarget);
+			glTextureStorage2DMultisample(fb.colorTarget, samples, colorFormat, width, height, GL_TRUE);
+			glNamedFramebufferTexture(fb.id, GL_COLOR_ATTACHMENT0, fb.colorTarget, 0);
 		}
 		else 
 		{
 			glCreateTextures(GL_TEXTURE_2D, 1, &fb.colorTarget);
 			glTextureStorage2D(fb.colorTarget, 1, colorFormat, width, height);
+			// ڷλòTAA ͶӰŴ󣩣ʹ˫Թ˲нԵ
+			glTextureParameteri(fb.colorTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTextureParameteri(fb.colorTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(fb.colorTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glNamedFramebufferTexture(fb.id, GL_COLOR_ATTACHMENT0, fb.colorTarget, 0);
 		}
 	}
@@ -106,23 +232,32 @@ FrameBuffer Buffer::CreateFrameBuffer(int width, int height, int samples, GLenum
 	return fb;
 }
 
-void Buffer::ResolveFramebuffer(const FrameBuffer& srcFB, const FrameBuffer& dstFB)
+void Buffer::ResolveFramebuffer(const FrameBuffer& srcFB, const FrameBuffer& dstFB, int width, int height)
 {
 	if (srcFB.id == dstFB.id) return;
 
-	std::vector<GLenum> attachments;
+	// ÿ֡ãбջϣʶ
+	GLenum attachments[2];
+	GLsizei numAttachments = 0;
 	if (srcFB.colorTarget) 
 	{
-		attachments.push_back(GL_COLOR_ATTACHMENT0);
+		attachments[numAttachments++] = GL_COLOR_ATTACHMENT0;
 	}
 	if (srcFB.depthStencilTarget) 
 	{
-		attachments.push_back(GL_DEPTH_STENCIL_ATTACHMENT);
+		attachments[numAttachments++] = GL_DEPTH_STENCIL_ATTACHMENT;
 	}
-	assert(attachments.size() > 0);
+	assert(numAttachments > 0);
 
-	glBlitNamedFramebuffer(srcFB.id, dstFB.id, 0, 0, srcFB.width, srcFB.height, 0, 0, dstFB.width, dstFB.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-	glInvalidateNamedFramebufferData(srcFB.id, (GLsizei)attachments.size(), &attachments[0]);
+	if (width == 0 || height == 0)
+	{
+		glBlitNamedFramebuffer(srcFB.id, dstFB.id, 0, 0, srcFB.width, srcFB.height, 0, 0, dstFB.width, dstFB.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	else
+	{
+		glBlitNamedFramebuffer(srcFB.id, dstFB.id, 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glInvalidateNamedFramebufferData(srcFB.id, numAttachments, attachments);
 }
 
 void Buffer::DeleteFrameBuffer(FrameBuffer& fb)
@@ -133,14 +268,7 @@ void Buffer::DeleteFrameBuffer(FrameBuffer& fb)
 	}
 	if (fb.colorTarget) 
 	{
-		if (fb.samples == 0) 
-		{
-			glDeleteTextures(1, &fb.colorTarget);
-		}
-		else 
-		{
-			glDeleteRenderbuffers(1, &fb.colorTarget);
-		}
+		glDeleteTextures(1, &fb.colorTarget);
 	}
 	if (fb.depthStencilTarget) 
 	{
@@ -149,6 +277,14 @@ void Buffer::DeleteFrameBuffer(FrameBuffer& fb)
 	std::memset(&fb, 0, sizeof(FrameBuffer));
 }
 
+GLuint Buffer::CreateStorageBuffer(const void* data, size_t size)
+{
+	GLuint ssbo;					// Shader Storage Buffer Objectɫ洢
+	glCreateBuffers(1, &ssbo);
+	glNamedBufferStorage(ssbo, size, data, GL_DYNAMIC_STORAGE_BIT);
+	return ssbo;
+}
+
 GLuint Buffer::CreateUniformBuffer(const void* data, size_t size)
 {
 	GLuint ubo;						// Uniform Buffer Objectͳһ
@@ -10,7 +10,23 @@ struct MeshBuffer
 	GLuint ibo;				// ıʶ Index Buffer Object
 	GLuint vao;				// ıʶ Vertex Array Object
 	GLuint numElements;		// Ԫ綥
-	MeshBuffer() : vbo(0), ibo(0), vao(0) {}
+	GLuint firstIndex;		// 񻺳еĵһȡ·
+	GLint baseVertex;		// 񻺳еĵһ㣨ȡ·
+	MeshBuffer() : vbo(0), ibo(0), vao(0), numElements(0), firstIndex(0), baseVertex(0) {}
+};
+
+// 񻺳أѹڹĻС
+// ɫ gl_VertexID  SSBO ȡ㣬һûжԵ VAO
+struct MeshArena
+{
+	GLuint vertexBuffer;	// ѹ㣬Ϊ SSBO
+	GLuint indexBuffer;		// ͬʱΪ vao Ԫػ
+	GLuint vao;				// ֻ indexBuffer  VAO
+	GLuint vertexCapacity;	// 
+	GLuint indexCapacity;	// 
+	GLuint numVertices;		// ѷĶ
+	GLuint numIndices;		// ѷ
+	MeshArena() : vertexBuffer(0), indexBuffer(0), vao(0), vertexCapacity(0), indexCapacity(0), numVertices(0), numIndices(0) {}
 };
 
 struct FrameBuffer
@@ -29,11 +45,24 @@ public:
 	static MeshBuffer CreateMeshBuffer(const std::shared_ptr<class Mesh>& mesh);
 	static void DeleteMeshBuffer(MeshBuffer& buffer);
 
+	// ֻλãյ vec3ĶԤͨʹá indexBuffer д firstIndex ʼĲ֣
+	// ص MeshBuffer 
+	static MeshBuffer CreatePositionBuffer(const std::shared_ptr<class Mesh>& mesh, GLuint indexBuffer, GLuint firstIndex = 0);
+
+	static MeshArena CreateMeshArena(GLuint vertexCapacity, GLuint indexCapacity);
+	// ѹд뻺أص MeshBuffer κλ滺һͷ
+	static MeshBuffer AllocateMeshBuffer(MeshArena& arena, const std::shared_ptr<class Mesh>& mesh);
+	static void DeleteMeshArena(MeshArena& arena);
+	static constexpr size_t mkPackedVertexSize = 24;	// ȡ·ÿѹֽ
+
 	static FrameBuffer CreateFrameBuffer(int width, int height, int samples, GLenum colorFormat, GLenum depthstencilFormat);
-	static void ResolveFramebuffer(const FrameBuffer& srcfb, const FrameBuffer& dstfb);
+	// width/height Ϊ 0 ʱ֡壬ֻ½ǵ򣨶ֱ̬ʵӿڣ
+	static void ResolveFramebuffer(const FrameBuffer& srcfb, const FrameBuffer& dstfb, int width = 0, int height = 0);
 	static void DeleteFrameBuffer(FrameBuffer& fb);
 
 	static GLuint CreateUniformBuffer(const void* data, size_t size);
+	// ɫ洢SSBOݿ glNamedBufferSubData £Ҳɫд
+	static GLuint CreateStorageBuffer(const void* data, size_t size);
 	template<typename T> static GLuint CreateUniformBuffer(const T* data = nullptr)
 	{
 		return CreateUniformBuffer(data, sizeof(T));
@@ -0,0 +1,144 @@
+#include <cstring>
+#include <functional>
+#include "CommandList.h"
+#include "JobSystem.h"
+
+CommandList::CommandList(size_t reserveBytes)
+	: mNumCommands(0)
+{
+	mData.reserve(reserveBytes);
+}
+
+void CommandList::Reset()
+{
+	mData.clear();
+	mNumCommands = 0;
+}
+
+template<typename T> void CommandList::Push(Command command, const T& args)
+{
+	static_assert(alignof(T) <= alignof(Command) && sizeof(T) % alignof(Command) == 0, "Command arguments must be 4-byte aligned");
+	const size_t offset = mData.size();
+	mData.resize(offset + sizeof(Command) + sizeof(T));
+	std::memcpy(mData.data() + offset, &command, sizeof(Command));
+	std::memcpy(mData.data() + offset + sizeof(Command), &args, sizeof(T));
+	++mNumCommands;
+}
+
+void CommandList::UseProgram(GLuint program)
+{
+	Push(Command::UseProgram, program);
+}
+
+void CommandList::BindVertexArray(GLuint vao)
+{
+	Push(Command::BindVertexArray, vao);
+}
+
+void CommandList::BindTexture(GLuint unit, GLuint texture)
+{
+	Push(Command::BindTexture, BindTextureArgs{ unit, texture });
+}
+
+void CommandList::BindStorageBuffer(GLuint binding, GLuint buffer)
+{
+	Push(Command::BindStorageBuffer, BindStorageBufferArgs{ binding, buffer });
+}
+
+void CommandList::BindIndirectBuffer(GLuint buffer)
+{
+	Push(Command::BindIndirectBuffer, buffer);
+}
+
+void CommandList::Uniform1ui(GLuint program, GLint location, GLuint value)
+{
+	Push(Command::Uniform1ui, Uniform1uiArgs{ program, location, value });
+}
+
+void CommandList::DrawElements(GLuint count, GLuint firstIndex, GLuint instanceCount, GLint baseVertex, GLuint baseInstance)
+{
+	Push(Command::DrawElements, DrawElementsArgs{ count, firstIndex, instanceCount, baseVertex, baseInstance });
+}
+
+void CommandList::MultiDrawIndirect(GLuint offset, GLsizei drawCount)
+{
+	Push(Command::MultiDrawIndirect, MultiDrawIndirectArgs{ offset, drawCount });
+}
+
+// 读取一条命令的参数并前移游标
+template<typename T> static const T& Read(const uint8_t*& cursor)
+{
+	const T& args = *reinterpret_cast<const T*>(cursor);
+	cursor += sizeof(T);
+	return args;
+}
+
+void CommandList::Replay() const
+{
+	// 命令与参数在缓冲区中 4 字节对齐，直接按类型解释
+	const uint8_t* cursor = mData.data();
+	const uint8_t* const end = cursor + mData.size();
+	while (cursor < end)
+	{
+		const Command command = *reinterpret_cast<const Command*>(cursor);
+		cursor += sizeof(Command);
+		switch (command)
+		{
+		case Command::UseProgram:
+			glUseProgram(Read<GLuint>(cursor));
+			break;
+		case Command::BindVertexArray:
+			glBindVertexArray(Read<GLuint>(cursor));
+			break;
+		case Command::BindTexture:
+		{
+			const BindTextureArgs& a = Read<BindTextureArgs>(cursor);
+			glBindTextureUnit(a.unit, a.texture);
+			break;
+		}
+		case Command::BindStorageBuffer:
+		{
+			const BindStorageBufferArgs& a = Read<BindStorageBufferArgs>(cursor);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, a.binding, a.buffer);
+			break;
+		}
+		case Command::BindIndirectBuffer:
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, Read<GLuint>(cursor));
+			break;
+		case Command::Uniform1ui:
+		{
+			const Uniform1uiArgs& a = Read<Uniform1uiArgs>(cursor);
+			glProgramUniform1ui(a.program, a.location, a.value);
+			break;
+		}
+		case Command::DrawElements:
+		{
+			const DrawElementsArgs& a = Read<DrawElementsArgs>(cursor);
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, a.count, GL_UNSIGNED_INT,
+				reinterpret_cast<const void*>(size_t(a.firstIndex) * sizeof(GLuint)), a.instanceCount, a.baseVertex, a.baseInstance);
+			break;
+		}
+		case Command::MultiDrawIndirect:
+		{
+			const MultiDrawIndirectArgs& a = Read<MultiDrawIndirectArgs>(cursor);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(size_t(a.offset)), a.drawCount, 0);
+			break;
+		}
+		}
+	}
+}
+
+void CommandList::RecordParallel(std::vector<CommandList>& lists, size_t count,
+	const std::function<void(CommandList& list, size_t begin, size_t end)>& record)
+{
+	const size_t numLists = lists.size();
+	const auto body = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			lists[i].Reset();
+			record(lists[i], count * i / numLists, count * (i + 1) / numLists);
+		}
+	};
+	// 以引用包装传入：std::function 保存 reference_wrapper 时不访问通用堆，与捕获的大小和标准库实现无关
+	JobSystem::ParallelFor("Record command list", numLists, std::cref(body));
+}
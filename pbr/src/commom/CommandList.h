@@ -0,0 +1,74 @@
+#pragma once
+#ifndef __COMMANDLIST_H__
+#define __COMMANDLIST_H__
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 命令列表：把绑定、uniform 写入与绘制命令以紧凑的 POD 形式顺序写入线性缓冲区，
+// 录制不调用 GL，可以在任意线程进行（每个任务录制自己的列表）；之后由 GL 线程按顺序回放，
+// 回放只是一个按命令类型分派的循环。列表 Reset 后保留容量，每帧重复使用不再分配内存
+class CommandList
+{
+public:
+	explicit CommandList(size_t reserveBytes = 4096);
+
+	// 清空命令，保留缓冲区容量
+	void Reset();
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vao);
+	void BindTexture(GLuint unit, GLuint texture);
+	void BindStorageBuffer(GLuint binding, GLuint buffer);
+	void BindIndirectBuffer(GLuint buffer);
+	void Uniform1ui(GLuint program, GLint location, GLuint value);
+	// glDrawElementsInstancedBaseVertexBaseInstance，索引为 GL_UNSIGNED_INT 的三角形
+	void DrawElements(GLuint count, GLuint firstIndex, GLuint instanceCount, GLint baseVertex, GLuint baseInstance);
+	// glMultiDrawElementsIndirect，offset 为已绑定的间接命令缓冲区中的字节偏移
+	void MultiDrawIndirect(GLuint offset, GLsizei drawCount);
+
+	// 在 GL 线程按录制顺序执行全部命令
+	void Replay() const;
+
+	size_t NumCommands() const { return mNumCommands; }
+	size_t Bytes() const { return mData.size(); }
+
+	 /********************************************************************************
+	 * @brief		并行录制：把 [0, count) 平均分成 lists.size() 段，第 i 段录制到 lists[i]，各段作为任务在工作线程中执行
+	 *				（调用线程也参与），返回时全部录制完成，按顺序回放各列表即得到串行录制的结果
+	 *********************************************************************************
+	 * @param		lists 每段一个列表，录制前被 Reset
+	 * @param		count 要录制的元素数量
+	 * @param		record 录制 [begin, end) 到列表，各线程同时调用，只能读取共享数据
+	 ********************************************************************************/
+	static void RecordParallel(std::vector<CommandList>& lists, size_t count,
+		const std::function<void(CommandList& list, size_t begin, size_t end)>& record);
+
+private:
+	enum class Command : uint32_t
+	{
+		UseProgram,
+		BindVertexArray,
+		BindTexture,
+		BindStorageBuffer,
+		BindIndirectBuffer,
+		Uniform1ui,
+		DrawElements,
+		MultiDrawIndirect,
+	};
+
+	// 每条命令为 Command 加上对应的参数结构，全部字段 4 字节对齐
+	struct BindTextureArgs { GLuint unit; GLuint texture; };
+	struct BindStorageBufferArgs { GLuint binding; GLuint buffer; };
+	struct Uniform1uiArgs { GLuint program; GLint location; GLuint value; };
+	struct DrawElementsArgs { GLuint count; GLuint firstIndex; GLuint instanceCount; GLint baseVertex; GLuint baseInstance; };
+	struct MultiDrawIndirectArgs { GLuint offset; GLsizei drawCount; };
+
+	template<typename T> void Push(Command command, const T& args);
+
+	std::vector<uint8_t> mData;
+	size_t mNumCommands;
+};
+
+#endif // !__COMMANDLIST_H__
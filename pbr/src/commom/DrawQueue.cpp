@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <format>
+#include <numeric>
+#include "DrawQueue.h"
+#include "Log.h"
+#include "Path.h"
+
+DrawQueue::DrawQueue()
+	: mMaxDraws(0)
+	, mRecordBuffer(0)
+	, mCommandBuffer(0)
+	, mDrawIndexBuffer(0)
+	, mPassFirstRecord{}
+	, mPassNumRecords{}
+	, mLastItems(0)
+	, mLastBatches(0)
+	, mLastCommands(0)
+{
+}
+
+DrawQueue::~DrawQueue()
+{
+}
+
+void DrawQueue::Init(int maxDraws)
+{
+	LOG_ASSERT(maxDraws <= 0, "Draw queue capacity must be positive");
+	mMaxDraws = maxDraws;
+	glCreateBuffers(1, &mRecordBuffer);
+	glNamedBufferStorage(mRecordBuffer, maxDraws * sizeof(DrawRecord), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &mCommandBuffer);
+	glNamedBufferStorage(mCommandBuffer, maxDraws * sizeof(DrawCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	std::vector<GLuint> drawIndices(maxDraws);
+	std::iota(drawIndices.begin(), drawIndices.end(), 0u);
+	glCreateBuffers(1, &mDrawIndexBuffer);
+	glNamedBufferStorage(mDrawIndexBuffer, drawIndices.size() * sizeof(GLuint), drawIndices.data(), 0);
+
+	mItems.reserve(maxDraws);
+}
+
+void DrawQueue::Delete()
+{
+	glDeleteBuffers(1, &mRecordBuffer);
+	glDeleteBuffers(1, &mCommandBuffer);
+	glDeleteBuffers(1, &mDrawIndexBuffer);
+	mRecordBuffer = mCommandBuffer = mDrawIndexBuffer = 0;
+}
+
+void DrawQueue::AttachDrawIndex(GLuint vao) const
+{
+	const GLuint attribute = 15;
+	glVertexArrayVertexBuffer(vao, attribute, mDrawIndexBuffer, 0, sizeof(GLuint));
+	glVertexArrayBindingDivisor(vao, attribute, 1);
+	glEnableVertexArrayAttrib(vao, attribute);
+	glVertexArrayAttribIFormat(vao, attribute, 1, GL_UNSIGNED_INT, 0);
+	glVertexArrayAttribBinding(vao, attribute, attribute);
+}
+
+void DrawQueue::Clear()
+{
+	mItems.clear();
+	mPrograms.clear();
+	mMaterials.clear();
+	mSources.clear();
+}
+
+template<typename T> uint64_t DrawQueue::Intern(std::vector<T>& table, T value, int bits)
+{
+	for (size_t i = 0; i < table.size(); ++i)
+	{
+		if (table[i] == value) return i;
+	}
+	LOG_ASSERT(table.size() >= (size_t(1) << bits), "Too many distinct states in the draw queue");
+	table.push_back(value);
+	return table.size() - 1;
+}
+
+void DrawQueue::Add(DrawPass pass, GLuint program, const DrawMaterial* material, const DrawGeometry& geometry, const glm::mat4& model, float depth)
+{
+	LOG_ASSERT(mItems.size() >= size_t(mMaxDraws), "Draw queue out of capacity");
+
+	// 通道 | 程序 | 材质 | 顶点来源 | 深度
+	uint64_t key = static_cast<uint64_t>(pass);
+	key = (key << mkProgramBits) | Intern(mPrograms, program, mkProgramBits);
+	key = (key << mkMaterialBits) | Intern(mMaterials, material, mkMaterialBits);
+	key = (key << mkSourceBits) | Intern(mSources, geometry.vao, mkSourceBits);
+	key = (key << mkDepthBits) | static_cast<uint64_t>(glm::clamp(double(depth), 0.0, 1.0) * double(UINT32_MAX));
+
+	DrawItem item;
+	item.key = key;
+	item.program = program;
+	item.material = material;
+	item.geometry = geometry;
+	item.model = model;
+	mItems.push_back(item);
+}
+
+void DrawQueue::RadixSort()
+{
+	const size_t count = mItems.size();
+	mOrder.resize(count);
+	mScratch.resize(count);
+	std::iota(mOrder.begin(), mOrder.end(), 0u);
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t offsets[256] = {};
+		for (uint32_t index : mOrder)
+		{
+			++offsets[(mItems[index].key >> shift) & 0xFF];
+		}
+		// 所有键在这一字节上相同（例如只有一个通道或深度的高位相同），顺序不变
+		if (count == 0 || offsets[(mItems[mOrder[0]].key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+		size_t sum = 0;
+		for (size_t& offset : offsets)
+		{
+			const size_t digitCount = offset;
+			offset = sum;
+			sum += digitCount;
+		}
+		for (uint32_t index : mOrder)
+		{
+			mScratch[offsets[(mItems[index].key >> shift) & 0xFF]++] = index;
+		}
+		mOrder.swap(mScratch);
+	}
+}
+
+void DrawQueue::Build()
+{
+	RadixSort();
+
+	// 记录与命令只用于上传，放在帧分配器中
+	FrameVector<DrawRecord> records;
+	FrameVector<DrawCommand> commands;
+	records.reserve(mItems.size());
+	commands.reserve(mItems.size());
+	mBatches.clear();
+	std::fill(std::begin(mPassFirstRecord), std::end(mPassFirstRecord), 0u);
+	std::fill(std::begin(mPassNumRecords), std::end(mPassNumRecords), 0u);
+
+	for (uint32_t index : mOrder)
+	{
+		const DrawItem& item = mItems[index];
+		const DrawPass pass = static_cast<DrawPass>(item.key >> (64 - mkPassBits));
+		const DrawGeometry& geometry = item.geometry;
+
+		// 记录按排序后的顺序分配，同一批次、同一通道的记录连续
+		const GLuint record = static_cast<GLuint>(records.size());
+		records.push_back({ item.model, geometry.firstIndex, geometry.baseVertex, { 0, 0 } });
+		if (mPassNumRecords[static_cast<int>(pass)]++ == 0)
+		{
+			mPassFirstRecord[static_cast<int>(pass)] = record;
+		}
+
+		const bool sameBatch = !mBatches.empty() && mBatches.back().pass == pass && mBatches.back().program == item.program
+			&& mBatches.back().material == item.material && mBatches.back().vao == geometry.vao && mBatches.back().vertexStorage == geometry.vertexStorage;
+		if (!sameBatch)
+		{
+			mBatches.push_back({ pass, item.program, item.material, geometry.vao, geometry.vertexStorage, static_cast<GLuint>(commands.size()), 0 });
+		}
+
+		// 与上一条命令的几何相同且记录相邻时合并为实例化绘制
+		DrawBatch& batch = mBatches.back();
+		if (batch.numCommands > 0)
+		{
+			DrawCommand& last = commands.back();
+			if (last.count == geometry.numElements && last.firstIndex == geometry.firstIndex && last.baseVertex == geometry.baseVertex
+				&& last.baseInstance + last.instanceCount == record)
+			{
+				++last.instanceCount;
+				continue;
+			}
+		}
+		commands.push_back({ geometry.numElements, 1, geometry.firstIndex, geometry.baseVertex, record });
+		++batch.numCommands;
+	}
+
+	if (!records.empty())
+	{
+		glNamedBufferSubData(mRecordBuffer, 0, records.size() * sizeof(DrawRecord), records.data());
+		glNamedBufferSubData(mCommandBuffer, 0, commands.size() * sizeof(DrawCommand), commands.data());
+	}
+	RecordPasses();
+
+	if (mItems.size() != mLastItems || mBatches.size() != mLastBatches || commands.size() != mLastCommands)
+	{
+		LOG_INFO(std::format("Draw queue: {} draws in {} batches ({} indirect commands, {} programs, {} materials, {} vertex sources)",
+			mItems.size(), mBatches.size(), commands.size(), mPrograms.size(), mMaterials.size(), mSources.size()));
+		mLastItems = mItems.size();
+		mLastBatches = mBatches.size();
+		mLastCommands = commands.size();
+	}
+}
+
+void DrawQueue::Record(size_t firstBatch, size_t endBatch, CommandList& list) const
+{
+	// 每个列表单独回放，列表的第一个批次总是绑定全部状态，包括绘制记录与间接命令缓冲区
+	const DrawBatch* bound = nullptr;
+	for (size_t i = firstBatch; i < endBatch; ++i)
+	{
+		const DrawBatch& batch = mBatches[i];
+		if (!bound)
+		{
+			list.BindStorageBuffer(5, mRecordBuffer);
+			list.BindIndirectBuffer(mCommandBuffer);
+		}
+		if (!bound || batch.program != bound->program)
+		{
+			list.UseProgram(batch.program);
+		}
+		if (batch.material && (!bound || batch.material != bound->material))
+		{
+			for (GLuint unit = 0; unit < 4; ++unit)
+			{
+				list.BindTexture(unit, batch.material->textures[unit]);
+			}
+		}
+		if (!bound || batch.vao != bound->vao)
+		{
+			list.BindVertexArray(batch.vao);
+		}
+		if (batch.vertexStorage && (!bound || batch.vertexStorage != bound->vertexStorage))
+		{
+			list.BindStorageBuffer(0, batch.vertexStorage);
+		}
+		list.MultiDrawIndirect(static_cast<GLuint>(batch.firstCommand * sizeof(DrawCommand)), batch.numCommands);
+		bound = &batch;
+	}
+}
+
+void DrawQueue::RecordPasses()
+{
+	// 批次按通道排序，每个通道是一段连续的批次
+	size_t firstBatch = 0;
+	for (int pass = 0; pass < static_cast<int>(DrawPass::Count); ++pass)
+	{
+		size_t endBatch = firstBatch;
+		while (endBatch < mBatches.size() && static_cast<int>(mBatches[endBatch].pass) == pass)
+		{
+			++endBatch;
+		}
+
+		// 批次较少时在当前线程录制，启动线程的开销大于录制本身
+		const size_t numBatches = endBatch - firstBatch;
+		std::vector<CommandList>& lists = mPassLists[pass];
+		lists.resize(numBatches >= static_cast<size_t>(gParallelRecordMinBatches) ? gRecordLists : 1);
+		CommandList::RecordParallel(lists, numBatches, [this, firstBatch](CommandList& list, size_t begin, size_t end) {
+			Record(firstBatch + begin, firstBatch + end, list);
+		});
+		firstBatch = endBatch;
+	}
+}
+
+void DrawQueue::Submit(DrawPass pass) const
+{
+	for (const CommandList& list : mPassLists[static_cast<int>(pass)])
+	{
+		list.Replay();
+	}
+}
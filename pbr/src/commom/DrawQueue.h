@@ -0,0 +1,160 @@
+#pragma once
+#ifndef __DRAWQUEUE_H__
+#define __DRAWQUEUE_H__
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "CommandList.h"
+#include "FrameArena.h"
+
+// 绘制所属的通道，排序键的最高位：同一通道的绘制排在一起，由 Submit 一次提交
+enum class DrawPass : uint8_t { Shadow, DepthPrepass, Opaque, Visibility, Count };
+
+// 一次绘制使用的几何：VAO（含元素缓冲区）、顶点拉取时的顶点 SSBO（否则为 0）与索引范围
+struct DrawGeometry
+{
+	GLuint vao = 0;
+	GLuint vertexStorage = 0;
+	GLuint numElements = 0;
+	GLuint firstIndex = 0;
+	GLint baseVertex = 0;
+};
+
+// 材质纹理，绑定到纹理单元 0~3（反照率、法线、金属度、粗糙度）
+struct DrawMaterial
+{
+	GLuint textures[4] = { 0, 0, 0, 0 };
+};
+
+// 绘制队列：每帧收集带 64 位排序键的绘制，键从高位到低位依次为通道、程序、材质、顶点来源（网格缓冲区池或 VAO）与深度。
+// Build 对键做基数排序，为排序后的绘制分配连续的逐绘制记录（模型矩阵等，SSBO 绑定点 5），
+// 并把程序、材质与顶点来源都相同的一段合并为一次 glMultiDrawElementsIndirect：
+// 几何相同的相邻绘制合并为一条实例化命令，不同的几何各占一条命令。
+// 提交时只在状态变化时切换，每帧的状态切换与绘制调用次数只取决于不同状态的数量，而不是绘制数量。
+// OpenGL 4.5 的着色器没有 gl_BaseInstance/gl_DrawID：每个 VAO 的属性 15 是除数为 1 的序号缓冲区（0, 1, 2...），
+// 其值为 baseInstance + gl_InstanceID，即本实例的记录序号（见 include/draw_records.glsl）
+class DrawQueue
+{
+public:
+	DrawQueue();
+	~DrawQueue();
+
+	// maxDraws 为每帧绘制数量（逐绘制记录）的上限
+	void Init(int maxDraws);
+	void Delete();
+
+	// 为 VAO 添加属性 15（记录序号），在队列中使用的每个 VAO 创建后调用一次
+	void AttachDrawIndex(GLuint vao) const;
+
+	// 开始新的一帧，丢弃上一帧的绘制
+	void Clear();
+
+	 /********************************************************************************
+	 * @brief		加入一次绘制
+	 *********************************************************************************
+	 * @param		pass 所属通道
+	 * @param		program 使用的程序
+	 * @param		material 材质，nullptr 表示不绑定材质纹理（深度、阴影与可见性通道）
+	 * @param		geometry 几何
+	 * @param		model 模型矩阵
+	 * @param		depth 排序用的深度，[0, 1]，同一状态内由近到远
+	 ********************************************************************************/
+	void Add(DrawPass pass, GLuint program, const DrawMaterial* material, const DrawGeometry& geometry, const glm::mat4& model, float depth);
+
+	// 排序、合并并上传本帧的记录与间接绘制命令，并把每个通道录制为命令列表，在第一次 Submit 之前调用
+	void Build();
+
+	// 提交一个通道的全部绘制：按顺序回放通道的命令列表，每个列表开头绑定记录缓冲区与间接命令缓冲区
+	void Submit(DrawPass pass) const;
+
+	// 通道第一条记录的序号，记录在通道内连续（例如可见性缓冲区以此换算实例编号）
+	GLuint FirstRecord(DrawPass pass) const { return mPassFirstRecord[static_cast<int>(pass)]; }
+	// 通道的记录数量
+	GLuint NumRecords(DrawPass pass) const { return mPassNumRecords[static_cast<int>(pass)]; }
+	// 记录缓冲区，绑定点 5
+	GLuint RecordBuffer() const { return mRecordBuffer; }
+
+private:
+	// 与 include/draw_records.glsl 中的 DrawRecord 一致（std430）
+	struct DrawRecord
+	{
+		glm::mat4 model;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint padding[2];
+	};
+
+	// glMultiDrawElementsIndirect 的命令格式
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	struct DrawItem
+	{
+		uint64_t key;
+		GLuint program;
+		const DrawMaterial* material;
+		DrawGeometry geometry;
+		glm::mat4 model;
+	};
+
+	// 一段程序、材质与顶点来源都相同的绘制，对应一次多重绘制
+	struct DrawBatch
+	{
+		DrawPass pass;
+		GLuint program;
+		const DrawMaterial* material;
+		GLuint vao;
+		GLuint vertexStorage;
+		GLuint firstCommand;
+		GLuint numCommands;
+	};
+
+	static constexpr int mkPassBits = 4;
+	static constexpr int mkProgramBits = 10;
+	static constexpr int mkMaterialBits = 12;
+	static constexpr int mkSourceBits = 6;
+	static constexpr int mkDepthBits = 32;
+
+	// 把对象映射为排序键中的小序号，第一次出现时分配
+	template<typename T> static uint64_t Intern(std::vector<T>& table, T value, int bits);
+
+	// 按 64 位键的 LSD 基数排序（每轮 8 位），所有键在某一字节上相同时跳过该轮
+	void RadixSort();
+
+	// 把批次 [firstBatch, endBatch) 录制为命令列表，只在状态变化时切换程序、材质与 VAO；只读，可在多个线程同时调用
+	void Record(size_t firstBatch, size_t endBatch, CommandList& list) const;
+
+	// 为每个通道录制命令列表，批次数达到 gParallelRecordMinBatches 时分成 gRecordLists 个列表并行录制
+	void RecordPasses();
+
+	int mMaxDraws;
+	GLuint mRecordBuffer;				// 逐绘制记录
+	GLuint mCommandBuffer;				// 间接绘制命令
+	GLuint mDrawIndexBuffer;			// 0, 1, 2... 的序号，作为实例化属性 15
+
+	std::vector<DrawItem> mItems;
+	std::vector<uint32_t> mOrder;		// 排序后的绘制序号
+	std::vector<uint32_t> mScratch;
+	std::vector<DrawBatch> mBatches;
+	std::vector<CommandList> mPassLists[static_cast<int>(DrawPass::Count)];	// 每个通道按顺序回放的命令列表
+	GLuint mPassFirstRecord[static_cast<int>(DrawPass::Count)];
+	GLuint mPassNumRecords[static_cast<int>(DrawPass::Count)];
+
+	// 本帧排序键中出现的程序、材质与顶点来源
+	std::vector<GLuint> mPrograms;
+	std::vector<const DrawMaterial*> mMaterials;
+	std::vector<GLuint> mSources;
+
+	size_t mLastItems;					// 上一次输出统计时的绘制、批次与命令数量
+	size_t mLastBatches;
+	size_t mLastCommands;
+};
+
+#endif // !__DRAWQUEUE_H__
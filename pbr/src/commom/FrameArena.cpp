@@ -0,0 +1,113 @@
+#include <cstdlib>
+#include <format>
+#include <new>
+#include "FrameArena.h"
+#include "Log.h"
+
+namespace {
+	// 渲染线程开启统计，其他线程的分配（例如主线程发布快照）不计入
+	thread_local bool tTrackHeap = false;
+	thread_local uint64_t tHeapAllocations = 0;
+}
+
+#ifdef _DEBUG
+// 统计通用堆分配；数组与 nothrow 版本默认转发到这里
+void* operator new(std::size_t size)
+{
+	if (tTrackHeap)
+	{
+		++tHeapAllocations;
+	}
+	if (void* memory = std::malloc(size ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+#endif
+
+FrameArena::Half FrameArena::mHalves[2];
+std::atomic<int> FrameArena::mCurrent{ 0 };
+
+void FrameArena::Init(size_t bytesPerFrame)
+{
+	for (Half& half : mHalves)
+	{
+		half.memory.reset(new uint8_t[bytesPerFrame]);
+		half.capacity = bytesPerFrame;
+		half.offset = 0;
+	}
+	mCurrent = 0;
+}
+
+void FrameArena::Delete()
+{
+	for (Half& half : mHalves)
+	{
+		half.memory.reset();
+		half.capacity = 0;
+		half.offset = 0;
+		half.overflowBlocks.clear();
+		half.overflowBytes = 0;
+	}
+}
+
+void FrameArena::BeginFrame()
+{
+	tTrackHeap = true;
+	const int next = 1 - mCurrent.load(std::memory_order_relaxed);
+	Half& half = mHalves[next];
+
+	// 两帧之前这一半容量不足，按当时的总用量扩大，之后的帧不再溢出
+	if (half.overflowBytes > 0)
+	{
+		const size_t capacity = (half.capacity + half.overflowBytes) * 3 / 2;
+		LOG_WARN(std::format("Frame arena grew from {:.1f} KB to {:.1f} KB", half.capacity / 1024.0, capacity / 1024.0));
+		half.memory.reset(new uint8_t[capacity]);
+		half.capacity = capacity;
+		half.overflowBlocks.clear();
+		half.overflowBytes = 0;
+	}
+	half.offset.store(0, std::memory_order_relaxed);
+	mCurrent.store(next, std::memory_order_release);
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	Half& half = mHalves[mCurrent.load(std::memory_order_acquire)];
+	// 按最坏情况的对齐填充预留，原子加之后在预留的范围内对齐
+	const size_t reserved = bytes + alignment - 1;
+	const size_t offset = half.offset.fetch_add(reserved, std::memory_order_relaxed);
+	if (offset + reserved <= half.capacity)
+	{
+		const uintptr_t address = reinterpret_cast<uintptr_t>(half.memory.get()) + offset;
+		return reinterpret_cast<void*>((address + alignment - 1) & ~uintptr_t(alignment - 1));
+	}
+
+	std::lock_guard<std::mutex> lock(half.overflowMutex);
+	half.overflowBlocks.emplace_back(new uint8_t[reserved]);
+	half.overflowBytes += reserved;
+	const uintptr_t address = reinterpret_cast<uintptr_t>(half.overflowBlocks.back().get());
+	return reinterpret_cast<void*>((address + alignment - 1) & ~uintptr_t(alignment - 1));
+}
+
+size_t FrameArena::BytesUsed()
+{
+	const Half& half = mHalves[mCurrent.load(std::memory_order_acquire)];
+	return half.offset.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameArena::HeapAllocations()
+{
+	return tHeapAllocations;
+}
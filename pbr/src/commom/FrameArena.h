@@ -0,0 +1,73 @@
+#pragma once
+#ifndef __FRAMEARENA_H__
+#define __FRAMEARENA_H__
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 帧分配器：每帧的临时数据从线性缓冲区中顺序分配，不逐个释放，BeginFrame 时整体清空。
+// 缓冲区分为两半交替使用，上一帧分配的数据在本帧结束之前仍然有效（例如上一帧的帧图供导出）。
+// 分配是无锁的（原子偏移），工作线程中的任务也可以分配。容量不足时从堆中分配额外的块，
+// 下一次使用这一半时按本帧的总用量扩大容量，稳态帧不再访问通用堆。
+// 调试版本替换全局 operator new 统计调用 BeginFrame 的线程（渲染线程）中的堆分配次数
+class FrameArena
+{
+public:
+	// 每一半的初始容量
+	static void Init(size_t bytesPerFrame);
+	static void Delete();
+
+	// 开始新的一帧：切换到另一半并清空，只在渲染线程调用；同时在本线程开启堆分配统计
+	static void BeginFrame();
+
+	// 从当前帧分配，alignment 为 2 的幂；数据在下一帧结束之前有效
+	static void* Allocate(size_t bytes, size_t alignment);
+
+	// 本帧已分配的字节数
+	static size_t BytesUsed();
+
+	// 当前线程开启统计以来的通用堆分配次数（只在调试版本中统计，发布版本恒为 0）
+	static uint64_t HeapAllocations();
+
+private:
+	struct Half
+	{
+		std::unique_ptr<uint8_t[]> memory;
+		size_t capacity = 0;
+		std::atomic<size_t> offset{ 0 };
+		std::mutex overflowMutex;
+		std::vector<std::unique_ptr<uint8_t[]>> overflowBlocks;	// 容量不足时的额外分配
+		size_t overflowBytes = 0;
+	};
+
+	static Half mHalves[2];
+	static std::atomic<int> mCurrent;
+};
+
+// 从帧分配器分配的 STL 分配器，deallocate 不做任何事；容器的生命周期不能超过下一帧
+template<typename T>
+class FrameAllocator
+{
+public:
+	using value_type = T;
+
+	FrameAllocator() = default;
+	template<typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(FrameArena::Allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t) {}
+
+	template<typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+};
+
+// 每帧的临时数组；增长时旧的存储不会回收，已知大小时先 reserve
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif // !__FRAMEARENA_H__
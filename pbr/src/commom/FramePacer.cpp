@@ -0,0 +1,141 @@
+#include <thread>
+#include <chrono>
+#include <format>
+#include <algorithm>
+#include <GLFW/glfw3.h>
+#include "FramePacer.h"
+#include "Log.h"
+#include "Path.h"
+
+FramePacer::FramePacer()
+	: mFrameIndex(0)
+	, mClockOffset(0.0)
+	, mNextFrameTime(0.0)
+	, mReportFrames(0)
+	, mInputFrames(0)
+	, mLatencySum(0.0)
+	, mLatencyMax(0.0)
+	, mWaitSum(0.0)
+{
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::Init(int maxFramesInFlight)
+{
+	LOG_ASSERT(maxFramesInFlight <= 0, "Frames in flight must be positive");
+	mFrames.resize(maxFramesInFlight);
+	for (Frame& frame : mFrames)
+	{
+		glCreateQueries(GL_TIMESTAMP, 1, &frame.timestampQuery);
+	}
+	mFrameIndex = 0;
+	Calibrate();
+}
+
+void FramePacer::Delete()
+{
+	for (Frame& frame : mFrames)
+	{
+		if (frame.fence) glDeleteSync(frame.fence);
+		glDeleteQueries(1, &frame.timestampQuery);
+	}
+	mFrames.clear();
+}
+
+void FramePacer::WaitForFrameSlot()
+{
+	if (mFrames.empty())
+	{
+		return;
+	}
+
+	// 当前槽位保存的是 N 帧之前的栅栏；首次等待时把命令刷新给驱动，否则栅栏可能永远不会触发
+	const double waitStart = glfwGetTime();
+	Frame& frame = mFrames[mFrameIndex % mFrames.size()];
+	if (frame.fence)
+	{
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (true)
+		{
+			const GLenum result = glClientWaitSync(frame.fence, flags, 1000000000);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) break;
+			LOG_ASSERT(result == GL_WAIT_FAILED, "Failed to wait for frame fence");
+			flags = 0;
+		}
+		Retire(frame);
+	}
+
+	// 帧率限制：先休眠到目标时间之前 gLimiterSpinMs，再自旋到目标时间
+	if (gTargetFrameRate > 0.0)
+	{
+		const double spin = gLimiterSpinMs / 1000.0;
+		double now = glfwGetTime();
+		if (mNextFrameTime - now > spin)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(mNextFrameTime - now - spin));
+		}
+		while ((now = glfwGetTime()) < mNextFrameTime)
+		{
+			std::this_thread::yield();
+		}
+		// 落后超过一帧（例如空闲之后）时从现在重新计时，不追赶
+		mNextFrameTime = std::max(mNextFrameTime + 1.0 / gTargetFrameRate, now);
+	}
+	mWaitSum += glfwGetTime() - waitStart;
+}
+
+void FramePacer::EndFrame(double inputTime)
+{
+	if (mFrames.empty())
+	{
+		return;
+	}
+	Frame& frame = mFrames[mFrameIndex % mFrames.size()];
+	glQueryCounter(frame.timestampQuery, GL_TIMESTAMP);
+	frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame.inputTime = inputTime;
+	++mFrameIndex;
+}
+
+void FramePacer::Retire(Frame& frame)
+{
+	glDeleteSync(frame.fence);
+	frame.fence = nullptr;
+
+	// 栅栏在时间戳之后，结果已经可用，读取不会等待
+	if (frame.inputTime >= 0.0)
+	{
+		GLuint64 timestamp = 0;
+		glGetQueryObjectui64v(frame.timestampQuery, GL_QUERY_RESULT, &timestamp);
+		const double latency = timestamp * 1.0e-9 + mClockOffset - frame.inputTime;
+		mLatencySum += latency;
+		mLatencyMax = std::max(mLatencyMax, latency);
+		++mInputFrames;
+	}
+
+	if (++mReportFrames >= gLatencyReportFrames)
+	{
+		if (mInputFrames > 0)
+		{
+			LOG_INFO(std::format("Frame pacing [{} in flight]: input to GPU complete avg {:.2f} ms, max {:.2f} ms over {} input frames; CPU wait {:.2f} ms per frame",
+				mFrames.size(), mLatencySum / mInputFrames * 1000.0, mLatencyMax * 1000.0, mInputFrames, mWaitSum / mReportFrames * 1000.0));
+		}
+		mReportFrames = 0;
+		mInputFrames = 0;
+		mLatencySum = 0.0;
+		mLatencyMax = 0.0;
+		mWaitSum = 0.0;
+		// 两个时钟会缓慢漂移，每次输出统计后重新测量
+		Calibrate();
+	}
+}
+
+void FramePacer::Calibrate()
+{
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	mClockOffset = glfwGetTime() - gpuTime * 1.0e-9;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef __FRAMEPACER_H__
+#define __FRAMEPACER_H__
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+// 帧节奏控制：每帧提交呈现后插入栅栏与时间戳查询，开始新的一帧之前等待 N 帧之前的栅栏，
+// CPU 最多领先 GPU N 帧（N = 1 为低延迟模式：上一帧完成后才取得输入并提交）。
+// 可选的帧率限制先休眠、最后一小段自旋，避免休眠精度不足造成的抖动。
+// 时间戳换算到 glfwGetTime 的时钟，统计每帧从输入事件到 GPU 完成该帧的延迟
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer();
+
+	void Init(int maxFramesInFlight);
+	void Delete();
+
+	// 开始新的一帧之前调用：等待 N 帧之前的栅栏，再按目标帧率限制
+	void WaitForFrameSlot();
+
+	 /********************************************************************************
+	 * @brief		提交呈现之后调用：插入本帧的时间戳查询与栅栏
+	 *********************************************************************************
+	 * @param		inputTime 本帧依据的第一个输入事件的时间（glfwGetTime），小于 0 表示没有输入
+	 ********************************************************************************/
+	void EndFrame(double inputTime);
+
+private:
+	struct Frame
+	{
+		GLsync fence = nullptr;
+		GLuint timestampQuery = 0;
+		double inputTime = -1.0;
+	};
+
+	// 栅栏已触发的帧：读取时间戳并计入统计
+	void Retire(Frame& frame);
+
+	// 重新测量 GPU 时间戳与 glfwGetTime 之间的偏移
+	void Calibrate();
+
+	std::vector<Frame> mFrames;			// 每个在途帧一个槽位
+	uint32_t mFrameIndex;				// 已提交的帧数
+	double mClockOffset;				// glfwGetTime - GPU 时间戳（秒）
+	double mNextFrameTime;				// 帧率限制：下一帧最早的开始时间
+
+	// 每 gLatencyReportFrames 帧输出一次的统计
+	int mReportFrames;
+	int mInputFrames;
+	double mLatencySum;
+	double mLatencyMax;
+	double mWaitSum;
+};
+
+#endif // !__FRAMEPACER_H__
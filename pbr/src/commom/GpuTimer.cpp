@@ -0,0 +1,76 @@
+#include "GpuTimer.h"
+#include "Log.h"
+
+GpuTimer::GpuTimer()
+	: mWriteIndex(0)
+	, mReadIndex(0)
+	, mActive(false)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+}
+
+void GpuTimer::Init(int ringSize)
+{
+	LOG_ASSERT(ringSize <= 0, "GPU timer ring size must be positive");
+	mQueries.resize(ringSize * 2);
+	glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(mQueries.size()), mQueries.data());
+	mWriteIndex = 0;
+	mReadIndex = 0;
+}
+
+void GpuTimer::Delete()
+{
+	if (!mQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(mQueries.size()), mQueries.data());
+		mQueries.clear();
+	}
+}
+
+void GpuTimer::Begin()
+{
+	const uint32_t ringSize = static_cast<uint32_t>(mQueries.size() / 2);
+	mActive = ringSize > 0 && mWriteIndex - mReadIndex < ringSize;
+	if (mActive)
+	{
+		glQueryCounter(mQueries[(mWriteIndex % ringSize) * 2], GL_TIMESTAMP);
+	}
+}
+
+void GpuTimer::End()
+{
+	if (mActive)
+	{
+		const uint32_t ringSize = static_cast<uint32_t>(mQueries.size() / 2);
+		glQueryCounter(mQueries[(mWriteIndex % ringSize) * 2 + 1], GL_TIMESTAMP);
+		++mWriteIndex;
+		mActive = false;
+	}
+}
+
+bool GpuTimer::Poll(float& ms)
+{
+	const uint32_t ringSize = static_cast<uint32_t>(mQueries.size() / 2);
+	bool updated = false;
+	while (mReadIndex != mWriteIndex)
+	{
+		// 结束查询可用时开始查询一定也可用
+		const GLuint* pair = &mQueries[(mReadIndex % ringSize) * 2];
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(pair[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &end);
+		ms = static_cast<float>(end - begin) / 1.0e6f;
+		++mReadIndex;
+		updated = true;
+	}
+	return updated;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef __GPUTIMER_H__
+#define __GPUTIMER_H__
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+// GPU 计时查询环：每次计时使用环中的下一对时间戳查询，只读取已经可用的旧结果，
+// 因此结果会滞后几帧，但读取时不会等待 GPU。
+// 使用 glQueryCounter 时间戳而不是 GL_TIME_ELAPSED，计时区间内可以嵌套其他 GL_TIME_ELAPSED 查询
+class GpuTimer
+{
+public:
+	GpuTimer();
+	~GpuTimer();
+
+	void Init(int ringSize = 4);
+	void Delete();
+
+	// 环已满（结果都未读取）时跳过本次计时，不会覆盖未读取的查询
+	void Begin();
+	void End();
+
+	 /********************************************************************************
+	 * @brief		读取所有已经可用的计时结果
+	 *********************************************************************************
+	 * @param		ms 输出：最近一次可用的 GPU 时间，单位为毫秒
+	 * @return		是否有新的结果
+	 ********************************************************************************/
+	bool Poll(float& ms);
+
+private:
+	std::vector<GLuint> mQueries;		// 每次计时占用两个相邻的查询：开始、结束
+	uint32_t mWriteIndex;				// 已提交的计时次数
+	uint32_t mReadIndex;				// 已读取的计时次数
+	bool mActive;						// Begin 是否开始了计时
+};
+
+#endif // !__GPUTIMER_H__
@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <utility>
+#include "JobSystem.h"
+#include "Log.h"
+
+namespace {
+	// 当前线程的工作线程序号，非工作线程为 -1
+	thread_local int tWorkerIndex = -1;
+}
+
+std::vector<std::unique_ptr<JobSystem::WorkerQueue>> JobSystem::mQueues;
+std::vector<std::thread> JobSystem::mWorkers;
+std::mutex JobSystem::mSleepMutex;
+std::condition_variable JobSystem::mWake;
+std::atomic<int> JobSystem::mQueued{ 0 };
+std::atomic<bool> JobSystem::mStop{ false };
+std::atomic<uint32_t> JobSystem::mNextQueue{ 0 };
+std::mutex JobSystem::mStatsMutex;
+std::unordered_map<std::string_view, JobSystem::JobStats> JobSystem::mStats;
+
+JobCounter::JobCounter()
+	: mPending(0)
+{
+}
+
+JobCounter::~JobCounter()
+{
+}
+
+void JobSystem::Init(int numWorkers)
+{
+	LOG_ASSERT(!mWorkers.empty(), "Job system is already running");
+	if (numWorkers <= 0)
+	{
+		numWorkers = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+	}
+	mStop = false;
+	for (int i = 0; i < numWorkers; ++i)
+	{
+		mQueues.push_back(std::make_unique<WorkerQueue>());
+	}
+	for (int i = 0; i < numWorkers; ++i)
+	{
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, i);
+	}
+	LOG_INFO(std::format("Job system: {} workers", numWorkers));
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStop = true;
+	}
+	mWake.notify_all();
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+	mWorkers.clear();
+	mQueues.clear();
+}
+
+int JobSystem::NumWorkers()
+{
+	return static_cast<int>(mWorkers.size());
+}
+
+void JobSystem::Run(const char* name, std::function<void()> job, JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->mPending.fetch_add(1, std::memory_order_relaxed);
+	}
+	Push({ name, std::move(job), counter });
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, const char* name, std::function<void()> job, JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->mPending.fetch_add(1, std::memory_order_relaxed);
+	}
+	{
+		std::lock_guard<std::mutex> lock(dependency.mMutex);
+		if (!dependency.Done())
+		{
+			dependency.mContinuations.push_back({ name, std::move(job), counter });
+			return;
+		}
+	}
+	Push({ name, std::move(job), counter });
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.Done())
+	{
+		if (TryRunOne(&counter)) continue;
+		// 剩余的任务正在其他线程上执行：阻塞到归零，或者又有属于本计数的任务入队
+		std::unique_lock<std::mutex> lock(counter.mMutex);
+		counter.mChanged.wait(lock, [&counter]() { return counter.Done() || counter.mQueued.load(std::memory_order_acquire) > 0; });
+	}
+	// 最后一个任务在释放互斥量之后计数器才可以被销毁
+	std::lock_guard<std::mutex> lock(counter.mMutex);
+	if (counter.mError)
+	{
+		std::rethrow_exception(std::exchange(counter.mError, nullptr));
+	}
+}
+
+void JobSystem::ParallelFor(const char* name, size_t count, const std::function<void(size_t begin, size_t end)>& body, size_t minChunk)
+{
+	if (count == 0) return;
+
+	// 每个线程约 4 块，块之间的耗时不均匀时仍能通过窃取平衡
+	const size_t maxChunks = (mQueues.size() + 1) * 4;
+	const size_t numChunks = std::min((count + std::max(minChunk, size_t(1)) - 1) / std::max(minChunk, size_t(1)), maxChunks);
+	if (numChunks == 1)
+	{
+		// 只有一块时直接在调用线程执行，不经过队列
+		const auto start = std::chrono::steady_clock::now();
+		body(0, count);
+		RecordStats(name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		return;
+	}
+
+	// 任务只捕获范围描述的地址与块序号，可以放入 std::function 的内部存储
+	struct Range
+	{
+		const std::function<void(size_t, size_t)>& body;
+		size_t count;
+		size_t numChunks;
+	} range{ body, count, numChunks };
+	JobCounter counter;
+	for (size_t chunk = 0; chunk < numChunks; ++chunk)
+	{
+		Run(name, [&range, chunk]() { range.body(range.count * chunk / range.numChunks, range.count * (chunk + 1) / range.numChunks); }, &counter);
+	}
+	Wait(counter);
+}
+
+void JobSystem::ReportStats(const std::string& label)
+{
+	std::vector<std::pair<std::string, JobStats>> stats;
+	{
+		std::lock_guard<std::mutex> lock(mStatsMutex);
+		stats.assign(mStats.begin(), mStats.end());
+		mStats.clear();
+	}
+	std::sort(stats.begin(), stats.end(), [](const auto& a, const auto& b) { return a.second.totalMs > b.second.totalMs; });
+	for (const auto& [name, job] : stats)
+	{
+		LOG_INFO(std::format("Jobs [{}] {}: {} runs, {:.3f} ms total, {:.3f} ms max",
+			label, name, job.count, job.totalMs, job.maxMs));
+	}
+}
+
+void JobSystem::Push(Job job)
+{
+	// 没有工作线程时立即执行
+	if (mQueues.empty())
+	{
+		Execute(job);
+		return;
+	}
+	const size_t queue = tWorkerIndex >= 0 ? tWorkerIndex : mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+	if (JobCounter* counter = job.counter)
+	{
+		// 入队与通知都在计数器的互斥量内：与 Wait 中的检查互斥，避免丢失唤醒；
+		// 任务在释放互斥量之前不能完成计数，计数器在通知时仍然存在
+		std::lock_guard<std::mutex> counterLock(counter->mMutex);
+		counter->mQueued.fetch_add(1, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> lock(mQueues[queue]->mutex);
+			mQueues[queue]->PushBack(std::move(job));
+		}
+		mQueued.fetch_add(1, std::memory_order_release);
+		counter->mChanged.notify_all();
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(mQueues[queue]->mutex);
+		mQueues[queue]->PushBack(std::move(job));
+		mQueued.fetch_add(1, std::memory_order_release);
+	}
+	{
+		// 与 WorkerLoop 中的检查互斥，避免丢失唤醒
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+	}
+	mWake.notify_one();
+}
+
+bool JobSystem::TryRunOne(JobCounter* only)
+{
+	const size_t numQueues = mQueues.size();
+	if (numQueues == 0) return false;
+	if (only ? only->mQueued.load(std::memory_order_acquire) == 0 : mQueued.load(std::memory_order_acquire) == 0) return false;
+
+	Job job;
+	bool found = false;
+	if (tWorkerIndex >= 0)
+	{
+		WorkerQueue& own = *mQueues[tWorkerIndex];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (only)
+		{
+			found = own.TakeFor(only, job);
+		}
+		else if (own.count > 0)
+		{
+			job = own.PopBack();
+			found = true;
+		}
+	}
+	const size_t start = tWorkerIndex >= 0 ? tWorkerIndex + 1 : 0;
+	for (size_t i = 0; i < numQueues && !found; ++i)
+	{
+		WorkerQueue& victim = *mQueues[(start + i) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (only)
+		{
+			found = victim.TakeFor(only, job);
+		}
+		else if (victim.count > 0)
+		{
+			job = victim.PopFront();
+			found = true;
+		}
+	}
+	if (!found) return false;
+
+	Dequeued(job);
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Dequeued(Job& job)
+{
+	mQueued.fetch_sub(1, std::memory_order_relaxed);
+	if (job.counter)
+	{
+		job.counter->mQueued.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::Execute(Job& job)
+{
+	const auto start = std::chrono::steady_clock::now();
+	try
+	{
+		job.job();
+	}
+	catch (...)
+	{
+		if (job.counter)
+		{
+			std::lock_guard<std::mutex> lock(job.counter->mMutex);
+			if (!job.counter->mError) job.counter->mError = std::current_exception();
+		}
+		else
+		{
+			LOG_ERROR(std::format("Job '{}' threw an exception with no counter to report it", job.name));
+		}
+	}
+	RecordStats(job.name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	// 任务对象（及其捕获）在完成计数之前释放，等待者返回后不再引用调用方的栈
+	job.job = nullptr;
+	Complete(job.counter);
+}
+
+void JobSystem::RecordStats(const char* name, double ms)
+{
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	JobStats& stats = mStats[name];
+	++stats.count;
+	stats.totalMs += ms;
+	stats.maxMs = std::max(stats.maxMs, ms);
+}
+
+void JobSystem::Complete(JobCounter* counter)
+{
+	if (!counter) return;
+	std::vector<JobCounter::Continuation> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->mMutex);
+		if (counter->mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(counter->mContinuations);
+			// 持有互斥量时通知，等待者返回（计数器可能随之销毁）之前通知已经完成
+			counter->mChanged.notify_all();
+		}
+	}
+	for (JobCounter::Continuation& continuation : ready)
+	{
+		Push({ continuation.name, std::move(continuation.job), continuation.counter });
+	}
+}
+
+void JobSystem::WorkerQueue::PushBack(Job&& job)
+{
+	if (count == slots.size())
+	{
+		// 按顺序搬到新的缓冲区，头部从 0 开始
+		std::vector<Job> grown(std::max<size_t>(slots.size() * 2, 64));
+		for (size_t i = 0; i < count; ++i)
+		{
+			grown[i] = std::move(slots[(head + i) % slots.size()]);
+		}
+		slots.swap(grown);
+		head = 0;
+	}
+	slots[(head + count) % slots.size()] = std::move(job);
+	++count;
+}
+
+JobSystem::Job JobSystem::WorkerQueue::PopBack()
+{
+	--count;
+	return std::move(slots[(head + count) % slots.size()]);
+}
+
+JobSystem::Job JobSystem::WorkerQueue::PopFront()
+{
+	Job job = std::move(slots[head]);
+	head = (head + 1) % slots.size();
+	--count;
+	return job;
+}
+
+bool JobSystem::WorkerQueue::TakeFor(const JobCounter* counter, Job& job)
+{
+	for (size_t i = count; i-- > 0;)
+	{
+		Job& candidate = slots[(head + i) % slots.size()];
+		if (candidate.counter != counter) continue;
+		job = std::move(candidate);
+		for (size_t j = i + 1; j < count; ++j)
+		{
+			slots[(head + j - 1) % slots.size()] = std::move(slots[(head + j) % slots.size()]);
+		}
+		--count;
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::WorkerLoop(int index)
+{
+	tWorkerIndex = index;
+	while (true)
+	{
+		if (TryRunOne()) continue;
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mWake.wait(lock, []() { return mStop.load() || mQueued.load() > 0; });
+		if (mStop && mQueued.load() == 0) return;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+#ifndef __JOBSYSTEM_H__
+#define __JOBSYSTEM_H__
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 依赖计数：交给 Run 的任务在提交时加一、完成时减一，归零时把通过 RunAfter 挂在它上面的后续任务加入队列
+class JobCounter
+{
+public:
+	JobCounter();
+	~JobCounter();
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool Done() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	struct Continuation
+	{
+		const char* name;
+		std::function<void()> job;
+		JobCounter* counter;
+	};
+
+	std::atomic<int> mPending;
+	std::atomic<int> mQueued{ 0 };		// 在队列中等待执行的本计数器的任务数量
+	std::mutex mMutex;					// 保护 mContinuations、mError 与归零时的交接
+	std::condition_variable mChanged;	// 归零或有新的任务入队时通知等待者
+	std::vector<Continuation> mContinuations;
+	std::exception_ptr mError;			// 第一个抛出异常的任务，由 Wait 重新抛出
+};
+
+// 工作窃取的任务调度器，加载、预计算与每帧的 CPU 工作共用同一组工作线程。
+// 每个工作线程有自己的双端队列：自己从尾部取（后进先出，缓存友好），空闲时从其他线程的头部窃取。
+// 等待（Wait、ParallelFor）时只执行队列中属于被等待计数器的任务（不会在渲染线程上执行无关的长任务），
+// 没有可执行的任务时阻塞直到计数归零，因此任务内部可以再提交并等待子任务。
+// 等待者不执行其他计数器的任务：被等待的任务不能通过 RunAfter 依赖于其他正在等待的线程才能完成的任务。
+// 每个任务按名称统计次数与耗时，由 ReportStats 输出。未 Init 时所有任务在调用线程中立即执行
+class JobSystem
+{
+public:
+	 /********************************************************************************
+	 * @brief		启动工作线程
+	 *********************************************************************************
+	 * @param		numWorkers 工作线程数量，0 表示硬件线程数减一（调用线程在等待时也执行任务）
+	 ********************************************************************************/
+	static void Init(int numWorkers = 0);
+	// 执行完队列中剩余的任务后结束工作线程
+	static void Shutdown();
+	static int NumWorkers();
+
+	 /********************************************************************************
+	 * @brief		提交一个任务
+	 *********************************************************************************
+	 * @param		name 统计用的名称，必须是字符串常量
+	 * @param		job 任务
+	 * @param		counter 非空时在提交时加一、任务完成时减一
+	 ********************************************************************************/
+	static void Run(const char* name, std::function<void()> job, JobCounter* counter = nullptr);
+
+	// 在 dependency 归零后再提交任务（已经归零时立即提交），counter 立即加一
+	static void RunAfter(JobCounter& dependency, const char* name, std::function<void()> job, JobCounter* counter = nullptr);
+
+	// 等待计数归零，期间在调用线程中执行队列中属于该计数的任务，没有时阻塞；计数上的任务抛出过异常时重新抛出第一个
+	static void Wait(JobCounter& counter);
+
+	 /********************************************************************************
+	 * @brief		并行执行 [0, count)：按工作线程数自动分块，每块至少 minChunk 个元素，调用线程参与执行并等待全部完成
+	 *********************************************************************************
+	 * @param		name 统计用的名称
+	 * @param		count 元素数量
+	 * @param		body 处理 [begin, end)，在多个线程中同时调用
+	 * @param		minChunk 每块的最少元素数量，元素较轻时增大以减少调度开销
+	 ********************************************************************************/
+	static void ParallelFor(const char* name, size_t count, const std::function<void(size_t begin, size_t end)>& body, size_t minChunk = 1);
+
+	// 输出上一次报告以来每种任务的次数、总耗时与最长耗时，并清空统计
+	static void ReportStats(const std::string& label);
+
+private:
+	struct Job
+	{
+		const char* name;
+		std::function<void()> job;
+		JobCounter* counter;
+	};
+
+	// 一个工作线程的任务队列：容量只增不减的环形缓冲区，稳态下提交任务不访问通用堆
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::vector<Job> slots;
+		size_t head = 0;
+		size_t count = 0;
+
+		void PushBack(Job&& job);
+		Job PopBack();
+		Job PopFront();
+		// 取出属于 counter 的最后一个任务，其后的任务前移
+		bool TakeFor(const JobCounter* counter, Job& job);
+	};
+
+	struct JobStats
+	{
+		size_t count = 0;
+		double totalMs = 0.0;
+		double maxMs = 0.0;
+	};
+
+	static void Push(Job job);
+	// 取出并执行一个任务：工作线程先取自己队列的尾部，再从其他队列的头部窃取；
+	// only 非空时只取属于它的任务（等待者），先找自己的队列
+	static bool TryRunOne(JobCounter* only = nullptr);
+	static void Dequeued(Job& job);
+	static void Execute(Job& job);
+	static void RecordStats(const char* name, double ms);
+	static void Complete(JobCounter* counter);
+	static void WorkerLoop(int index);
+
+	static std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+	static std::vector<std::thread> mWorkers;
+	static std::mutex mSleepMutex;
+	static std::condition_variable mWake;
+	static std::atomic<int> mQueued;			// 所有队列中等待执行的任务数量
+	static std::atomic<bool> mStop;
+	static std::atomic<uint32_t> mNextQueue;	// 非工作线程提交任务时轮流选择队列
+	static std::mutex mStatsMutex;
+	static std::unordered_map<std::string_view, JobStats> mStats;	// 按名称（字符串常量）统计
+};
+
+#endif // !__JOBSYSTEM_H__
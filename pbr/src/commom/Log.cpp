@@ -1,5 +1,7 @@
 #include "Log.h"
 #include <format>
+#include <mutex>
+#include <atomic>
 
 //  ANSI תÿ̨ɫ
 #define RESET       "\033[0m"
@@ -11,6 +13,8 @@
 #define CYAN        "\033[36m"
 #define WHITE       "\033[37m"
 
+static std::atomic<uint64_t> gMessageCount{ 0 };      // ־
+
 void Log::WriteLog(Level level, const std::string& message, const std::string& file, int line, const std::string& func)
 {
     std::string levelStr;
@@ -44,9 +48,18 @@ void Log::WriteLog(Level level, const std::string& message, const std::string& f
     }
 
     std::string formattedMessage = std::format("{}{} [{}] {} {}", color, CurrentDateTime(), levelStr, message,endMessage);
+    gMessageCount.fetch_add(1, std::memory_order_relaxed);
+    // ϵͳĹ߳Ҳд־⽻
+    static std::mutex outputMutex;
+    std::lock_guard<std::mutex> lock(outputMutex);
     std::cout << formattedMessage << RESET << std::endl;  // β ANSI תɫ
 }
 
+uint64_t Log::MessageCount()
+{
+    return gMessageCount.load(std::memory_order_relaxed);
+}
+
 void Log::AssertLog(bool condition, const std::string& message, const std::string& file, int line, const std::string& func)
 {
     if (condition)
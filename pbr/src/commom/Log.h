@@ -7,6 +7,7 @@
 #include <sstream>
 #include <ctime>
 #include <iomanip>
+#include <cstdint>
 
 // ־,ںϵͳĺ궨гͻeͷ
 enum class Level
@@ -22,7 +23,8 @@ enum class Level
 #define LOG_INFO(message) Log::WriteLog(Level::eINFO, (message), __FILE__, __LINE__, __func__)
 #define LOG_WARN(message) Log::WriteLog(Level::eWARN, (message), __FILE__, __LINE__, __func__)
 #define LOG_ERROR(message) Log::WriteLog(Level::eERROR, (message), __FILE__, __LINE__, __func__)
-#define LOG_ASSERT(condition, message) Log::AssertLog((condition), (message), __FILE__, __LINE__, __func__)
+// жʱϢļַÿ֡õĶԲͨö
+#define LOG_ASSERT(condition, message) do { if (condition) Log::AssertLog(true, (message), __FILE__, __LINE__, __func__); } while (0)
 #define LOG_EXCEPTION(message) Log::WriteLog(Level::eEXCEPTION, (message), __FILE__, __LINE__, __func__)
 
 class Log
@@ -32,6 +34,8 @@ public:
         const std::string& file, int line, const std::string& func);
     static void AssertLog(bool condition, const std::string& message,
         const std::string& file, int line, const std::string& func);
+    // ־жһʱǷҪ¼¼
+    static uint64_t MessageCount();
 
 private:
     static std::string CurrentDateTime();
@@ -1,4 +1,5 @@
 #include <cstdio>
+#include <mutex>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/Importer.hpp>
@@ -6,6 +7,7 @@
 #include <assimp/LogStream.hpp>
 
 #include "Mesh.h"
+#include "JobSystem.h"
 #include "Path.h"
 
 namespace {
@@ -25,10 +27,14 @@ struct LogStream : public Assimp::LogStream
 {
 	static void Init()
 	{
-		if(Assimp::DefaultLogger::isNullLogger()) {
-			Assimp::DefaultLogger::create("", Assimp::Logger::VERBOSE);
-			Assimp::DefaultLogger::get()->attachStream(new LogStream, Assimp::Logger::Err | Assimp::Logger::Warn);
-		}
+		// ڶͬʱأֻһ
+		static std::once_flag created;
+		std::call_once(created, []() {
+			if(Assimp::DefaultLogger::isNullLogger()) {
+				Assimp::DefaultLogger::create("", Assimp::Logger::VERBOSE);
+				Assimp::DefaultLogger::get()->attachStream(new LogStream, Assimp::Logger::Err | Assimp::Logger::Warn);
+			}
+		});
 	}
 	// ̳ڸ
 	void write(const char* message) override
@@ -42,30 +48,34 @@ Mesh::Mesh(const aiMesh* mesh)
 	assert(mesh->HasPositions());
 	assert(mesh->HasNormals());
 
-	mVertices.reserve(mesh->mNumVertices);
-	for(size_t i=0; i<mVertices.capacity(); ++i) 
-	{
-		Vertex vertex;
-		vertex.position = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
-		vertex.normal = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
-		if(mesh->HasTangentsAndBitangents()) 
+	// λֿ鲢ת
+	mVertices.resize(mesh->mNumVertices);
+	JobSystem::ParallelFor("Mesh vertices", mVertices.size(), [&](size_t begin, size_t end) {
+		for(size_t i=begin; i<end; ++i) 
 		{
-			vertex.tangent = {mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z};
-			vertex.bitangent = {mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z};
+			Vertex& vertex = mVertices[i];
+			vertex.position = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
+			vertex.normal = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
+			if(mesh->HasTangentsAndBitangents()) 
+			{
+				vertex.tangent = {mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z};
+				vertex.bitangent = {mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z};
+			}
+			if(mesh->HasTextureCoords(0)) 
+			{
+				vertex.texcoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
+			}
 		}
-		if(mesh->HasTextureCoords(0)) 
+	}, gMeshChunkSize);
+	
+	mTriangle.resize(mesh->mNumFaces);
+	JobSystem::ParallelFor("Mesh triangles", mTriangle.size(), [&](size_t begin, size_t end) {
+		for(size_t i=begin; i<end; ++i) 
 		{
-			vertex.texcoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
+			assert(mesh->mFaces[i].mNumIndices == 3);
+			mTriangle[i] = {mesh->mFaces[i].mIndices[0], mesh->mFaces[i].mIndices[1], mesh->mFaces[i].mIndices[2]};
 		}
-		mVertices.push_back(vertex);
-	}
-	
-	mTriangle.reserve(mesh->mNumFaces);
-	for(size_t i=0; i<mTriangle.capacity(); ++i) 
-	{
-		assert(mesh->mFaces[i].mNumIndices == 3);
-		mTriangle.push_back({mesh->mFaces[i].mIndices[0], mesh->mFaces[i].mIndices[1], mesh->mFaces[i].mIndices[2]});
-	}
+	}, gMeshChunkSize);
 }
 
 std::shared_ptr<Mesh> Mesh::ReadFile(const std::string& filename1)
@@ -7,15 +7,115 @@
 const int gDisplaySizeX = 1920;         // ʾڵĿȣλΪ
 const int gDisplaySizeY = 1080;         // ʾڵĸ߶ȣλΪ
 const int gDisplaySamples = 16;			// ȾʱĲԽԽãҲӼ
+const bool gFusedResolve = true;		// MSAA ģʽɫӳֱӶȡĿ꣬ɫӳƽҪĿ
+
+// ɫHDRĿLean ʹ R11G11B10F4 ֽ/أû alphaβ 6/6/5 λ
+// High ʹ RGBA16F8 ֽ/أΪȲοĿ TAA ʷĿʹͬʽ
+enum class ColorQuality { Lean, High };
+const ColorQuality gColorQuality = ColorQuality::Lean;
+
+// ģʽMSAA ʹ gDisplaySamples ȾĿꣻ
+// TAA ʹõȾĿꡢͶӰʷͶӰԴӽϵ͵ڲֱʷŴ
+enum class AntiAliasing { MSAA, TAA };
+const AntiAliasing gAntiAliasing = AntiAliasing::MSAA;
+const float gRenderScale = 1.0f;		// TAA ģʽڲȾֱʾֱ֮ȣС 1 ʱ TAA Ŵ
+const float gTAAFeedback = 0.9f;		// TAA ʷ֡ĻȨ
+
+// ֱ̬ʣ GPU ֡ʱ [gMinRenderScale, gMaxRenderScale] ڵڲȾֱʣʾֱʣ
+// ȾĿ갴һԷ䣬ʱֻıӿڣɫӳ䣨 TAAŴʾֱ
+const bool gDynamicResolution = false;
+const float gTargetFrameMs = 16.0f;		// Ŀ GPU ֡ʱ䣬λΪ
+const float gMinRenderScale = 0.5f;
+const float gMaxRenderScale = 1.0f;
+// ԤֻͨλõĶдȣPBR ͨ GL_EQUAL ҲдȣÿɫһΡ
+// Auto ʱڲַʽ PBR ͨͨȲԵȻƣ֮ȣֵſ
+enum class DepthPrepass { Off, On, Auto };
+const DepthPrepass gDepthPrepass = DepthPrepass::Auto;
+const float gPrepassOverdrawThreshold = 1.3f;	// ԤͨĹȻֵԤͨĶ㴦դ
+const int gPrepassProbeFrames = 120;			// Auto ʱÿ֡һַʽȾһ֡²Ȼ
+
+// ִǰȾ׶ĻϻΪ gClusterGridX x gClusterGridY 飬ϰָΪ gClusterGridZ 㣬
+// ɫΪÿؼ¼ཻľֲԴPBR ƬԪֻڴصĹԴ
+const int gClusterGridX = 16;
+const int gClusterGridY = 9;
+const int gClusterGridZ = 24;
+const int gClusterMaxLights = 128;		// ÿؼ¼ĹԴޣ clustered_lights.glsl е ClusterMaxLights һ
+const int gMaxLocalLights = 4096;		// ֲԴ洢
+
+// ɵľֲԴԴ۹ƣΪ 0 ʱ
+const int gLocalLightCount = 0;
+const float gLightFieldRadius = 40.0f;	// ԴֲԭΪġ˰뾶
+const float gLocalLightRange = 15.0f;	// ֲԴӰ뾶
+const float gLocalLightIntensity = 100.0f;
+
+// Ӱÿ gShadowCascades ӰͼӾఴȻֵĻϣgShadowSplitLambdaּ
+// Ӱͼ棬ֻйԴ򡢳תΧ仯ʱȾ
+// һ仯£Զļתÿ֡һڼʹûݼ
+const bool gShadows = true;
+const int gShadowCascades = 4;			//  shadows.glsl е MaxShadowCascades
+const int gShadowMapSize = 1024;		// ÿӰͼı߳λΪ
+const float gShadowDistance = 400.0f;	// ӰǵӾ
+const float gShadowSplitLambda = 0.75f;
+
+// ȾͼȾ״̬ûб仯ʱȾѭ glfwWaitEventsTimeout ȴ룻
+// ֻҪˢʱ³һ֡ɫӳĽ
+const bool gOnDemandRendering = true;
+const double gIdleWaitSeconds = 0.5;	// ʱȴ¼ĳʱʱɫصȾ״̬
+const int gTAASettleFrames = 32;		// TAA ģʽ»澲ֹȾ֡ʷ֡
+const double gInputSampleRate = 240.0;	// ̷߳ͼ볡յƵʣȾڶ߳нУ
+
+// ࣺ֡ÿ֡ύֺդʼµһ֮֡ǰȴ gMaxFramesInFlight ֮֡ǰդ CPU  GPU ֡
+// 1 ΪӳģʽֵӳٻȡgTargetFrameRate  0 ʱ֡Ŀֵ
+const int gMaxFramesInFlight = 2;
+const double gTargetFrameRate = 0.0;
+const double gLimiterSpinMs = 2.0;		// ֡ȴʱߵľ
+const int gLatencyReportFrames = 120;	// ÿ֡־һӳͳ
+
+// ֡ͼʱȾĿӳз䣬ڲصͬĿ깲Դ棻֡ûʹõĿ걻ͷ
+const int gRenderGraphEvictFrames = 120;
+
 const float gViewDistance = 150.0f;     // ӵĿ֮ľ
 const float gViewFOV = 45.0f;           // ҰĽǶȴСλΪȣdegree
 const float gOrbitSpeed = 1.0f;         // תٶȣӰӵΧĿתٶ
 const float gZoomSpeed = 4.0f;          // ٶȣӰӵԶĿٶ
 
+// PBR ģ XZ ƽų gModelGrid x gModelGrid 񣨶ʱĻƶУ1 ʱֻԭ㴦һģ͡
+// ɼԻʵֻ 8 λ 256 ģ
+const int gModelGrid = 1;
+const float gModelSpacing = 60.0f;		// ģ͵ļ
+const int gMaxDraws = 4096;				// ƶÿ֡Ļޣͨ
+
+// ƶеͨﵽ gParallelRecordMinBatches ʱֳ gRecordLists бϵͳ¼
+const int gParallelRecordMinBatches = 256;
+const int gRecordLists = 4;
+// ϵͳĹ߳0 ʾӲ߳һ
+const int gJobWorkers = 0;
+const size_t gMeshChunkSize = 16384;		// תʱÿٶ㣨Σ
+
+// ֡ÿһĳʼʱԶ󣩣԰汾ǰ gHeapCheckWarmupFrames ̬֮֡֡ûͨöѷ
+const size_t gFrameArenaSize = 4 * 1024 * 1024;
+const int gHeapCheckWarmupFrames = 16;
+
+// פԴԤ㣨0 ʾƣʱ gTextureColdFrames ֡ûʹùü߳ gTextureTrimSize  MIPMAP β
+const size_t gTextureBudget = 256 * 1024 * 1024;
+const int gTextureColdFrames = 300;
+const int gTextureTrimSize = 64;
+// ʱϴ gTextureTrimSize µ MIPMAP βϸļ֮֡ʽϴÿ֡ gTextureUploadBudget ֽ
+const size_t gTextureUploadBudget = 4 * 1024 * 1024;
+
 // Parameters
 static constexpr int gEnvMapSize = 1024;		// ͼĴСڷ͹ռ㣩
 static constexpr int gIrradianceMapSize = 32;	// նͼĴСռ㣩
 static constexpr int gBRDF_LUT_Size = 256;		// BRDF ұĴСھ淴㣩
+static constexpr int gComputeGroupSize = 32;	// ԤɫĹ߳ GROUP_SIZE_X/Y
+static constexpr int gIrradianceSamples = 64 * 1024;	// նȾ
+static constexpr int gSpecularSamples = 1024;	// Ԥ˵
+static constexpr int gBRDFSamples = 1024;		// BRDF LUT ֵ
+static constexpr bool gEnableIBL = true;		// PBR ɫ壺ǷͼĻ
+static constexpr bool gEnableNormalMap = true;	// PBR ɫ壺Ƿʹ÷ͼ
+static constexpr bool gShaderHotReload = true;	//  shaders/glsl޸ĺں̨±벢滻
+static constexpr bool gVertexPulling = false;	// PBR ģʹ񻺳ص SSBO ȡѹ㣬ʹøԵ VAO
+static constexpr bool gRunBenchmarks = false;	// ɺȾ·ĶԱȲԣ־
 
 // ԹˣAnisotropic FilteringAFһļر۲
 // ӽǳʱmaxAnisotropyͨʾͼӲֵ֧Թ˼磬ֵΪ16ʾӲ
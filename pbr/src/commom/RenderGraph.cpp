@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <format>
+#include <sstream>
+#include "RenderGraph.h"
+#include "Log.h"
+#include "Path.h"
+
+static const char* FormatName(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RGBA8: return "RGBA8";
+	case GL_RGBA16F: return "RGBA16F";
+	case GL_R11F_G11F_B10F: return "R11G11B10F";
+	case GL_R32UI: return "R32UI";
+	case GL_DEPTH24_STENCIL8: return "D24S8";
+	case GL_DEPTH_COMPONENT32F: return "D32F";
+	default: return "?";
+	}
+}
+
+static double FormatBytes(GLenum format)
+{
+	switch (format)
+	{
+	case GL_NONE: return 0.0;
+	case GL_RGBA16F: return 8.0;
+	default: return 4.0;
+	}
+}
+
+void RenderGraph::PassBuilder::Read(Handle target)
+{
+	mGraph.mPasses[mPass].reads.push_back(target);
+}
+
+void RenderGraph::PassBuilder::Write(Handle target)
+{
+	mGraph.mPasses[mPass].writes.push_back(target);
+}
+
+void RenderGraph::PassBuilder::SideEffect()
+{
+	mGraph.mPasses[mPass].sideEffect = true;
+}
+
+RenderGraph::RenderGraph()
+	: mFrame(0)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+}
+
+RenderGraph::Handle RenderGraph::CreateTarget(const char* name, const RenderTargetDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	mResources.push_back(resource);
+	return static_cast<Handle>(mResources.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::ImportTarget(const char* name, const RenderTarget& target)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = target.desc;
+	resource.imported = true;
+	resource.target = target;
+	mResources.push_back(resource);
+	return static_cast<Handle>(mResources.size() - 1);
+}
+
+const RenderTarget& RenderGraph::Get(Handle target) const
+{
+	LOG_ASSERT(target < 0 || target >= static_cast<Handle>(mResources.size()), "Invalid render graph target");
+	return mResources[target].target;
+}
+
+void RenderGraph::Execute()
+{
+	PollTimers();
+	Cull();
+	Allocate();
+
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		Pass& pass = mPasses[i];
+		if (pass.culled) continue;
+
+		// 上一次的结果尚未取回时本帧不计时，不覆盖未读取的查询；只在第一次遇到通道名称时插入
+		auto found = mTimers.find(std::string_view(pass.name));
+		if (found == mTimers.end())
+		{
+			found = mTimers.emplace(pass.name, PassTimer()).first;
+		}
+		PassTimer& timer = found->second;
+		if (!timer.queries[0])
+		{
+			glCreateQueries(GL_TIMESTAMP, 2, timer.queries);
+		}
+		const bool timed = !timer.pending;
+		if (timed) glQueryCounter(timer.queries[0], GL_TIMESTAMP);
+		pass.invoke(pass.execute);
+		if (timed)
+		{
+			glQueryCounter(timer.queries[1], GL_TIMESTAMP);
+			timer.pending = true;
+		}
+
+		// 生命周期在这个通道结束的临时目标
+		for (const Resource& resource : mResources)
+		{
+			if (!resource.imported && resource.lastPass == i)
+			{
+				Invalidate(resource);
+			}
+		}
+	}
+
+	// 释放长时间没有使用的池中目标（例如切换渲染路径之后不再需要的目标）
+	for (size_t i = 0; i < mPool.size();)
+	{
+		if (mFrame - mPool[i].lastUsedFrame > static_cast<uint64_t>(gRenderGraphEvictFrames))
+		{
+			DeletePooledTarget(mPool[i].target);
+			mPool.erase(mPool.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	// 保留本帧的图供导出，清空的声明保留容量
+	mLastResources.swap(mResources);
+	mLastPasses.swap(mPasses);
+	mResources.clear();
+	mPasses.clear();
+	++mFrame;
+}
+
+std::string RenderGraph::ExportDot() const
+{
+	auto timerMs = [this](const char* name) {
+		const auto found = mTimers.find(std::string_view(name));
+		return found == mTimers.end() ? 0.0 : found->second.ms;
+	};
+	std::ostringstream dot;
+	dot << "digraph RenderGraph {\n\trankdir=LR;\n\tnode [fontname=\"Consolas\", fontsize=10];\n";
+	for (int i = 0; i < static_cast<int>(mLastPasses.size()); ++i)
+	{
+		const Pass& pass = mLastPasses[i];
+		if (pass.culled)
+		{
+			dot << std::format("\tpass{} [shape=box, style=dashed, label=\"{}\\n(culled)\"];\n", i, pass.name);
+		}
+		else
+		{
+			dot << std::format("\tpass{} [shape=box, style=\"rounded,filled\", fillcolor=lightblue, label=\"{}\\n{:.3f} ms\"];\n", i, pass.name, timerMs(pass.name));
+		}
+	}
+	for (int r = 0; r < static_cast<int>(mLastResources.size()); ++r)
+	{
+		const Resource& resource = mLastResources[r];
+		const RenderTargetDesc& desc = resource.desc;
+		std::string label = std::format("{}\\n{}x{}", resource.name, desc.width, desc.height);
+		if (desc.samples > 0) label += std::format(" x{}", desc.samples);
+		if (desc.colorFormat != GL_NONE) label += std::format(" {}", FormatName(desc.colorFormat));
+		if (desc.depthFormat != GL_NONE) label += std::format(" {}", FormatName(desc.depthFormat));
+		if (desc.velocity) label += " +RG16F";
+		if (resource.imported)
+		{
+			label += "\\nimported";
+		}
+		else if (resource.slot >= 0)
+		{
+			label += std::format("\\nslot {}, passes {}-{}", resource.slot, resource.firstPass, resource.lastPass);
+		}
+		dot << std::format("\ttarget{} [shape=ellipse, style={}, label=\"{}\"];\n", r, resource.imported ? "filled" : "solid", label);
+	}
+	for (int i = 0; i < static_cast<int>(mLastPasses.size()); ++i)
+	{
+		for (Handle read : mLastPasses[i].reads) dot << std::format("\ttarget{} -> pass{};\n", read, i);
+		for (Handle write : mLastPasses[i].writes) dot << std::format("\tpass{} -> target{};\n", i, write);
+	}
+	dot << "}\n";
+	return dot.str();
+
+}
+
+void RenderGraph::Delete()
+{
+	for (PooledTarget& pooled : mPool)
+	{
+		DeletePooledTarget(pooled.target);
+	}
+	mPool.clear();
+	for (auto& [name, timer] : mTimers)
+	{
+		if (timer.queries[0]) glDeleteQueries(2, timer.queries);
+	}
+	mTimers.clear();
+}
+
+void RenderGraph::Cull()
+{
+	// 从后向前：通道有副作用、写入导入目标，或写入之后有效通道读取的目标时有效，其读取的目标随之被需要
+	FrameVector<char> needed(mResources.size(), false);
+	for (int i = static_cast<int>(mPasses.size()) - 1; i >= 0; --i)
+	{
+		Pass& pass = mPasses[i];
+		bool alive = pass.sideEffect;
+		for (Handle write : pass.writes)
+		{
+			alive = alive || mResources[write].imported || needed[write];
+		}
+		pass.culled = !alive;
+		if (alive)
+		{
+			for (Handle read : pass.reads) needed[read] = true;
+		}
+	}
+}
+
+void RenderGraph::Allocate()
+{
+	// 有效通道中每个临时目标的生命周期
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		const Pass& pass = mPasses[i];
+		if (pass.culled) continue;
+		auto use = [&](Handle handle) {
+			Resource& resource = mResources[handle];
+			if (resource.firstPass < 0) resource.firstPass = i;
+			resource.lastPass = i;
+		};
+		for (Handle write : pass.writes) use(write);
+		for (Handle read : pass.reads) use(read);
+	}
+
+	// 按首次使用的顺序分配：描述相同、且上一个使用者的生命周期已经结束的池中目标可以共用
+	for (PooledTarget& pooled : mPool)
+	{
+		pooled.busyUntil = -1;
+	}
+	// 目标很少，插入排序（稳定，不像 std::stable_sort 那样申请临时缓冲区）
+	FrameVector<Handle> order;
+	order.reserve(mResources.size());
+	for (Handle r = 0; r < static_cast<Handle>(mResources.size()); ++r)
+	{
+		if (mResources[r].imported || mResources[r].firstPass < 0) continue;
+		order.push_back(r);
+		for (size_t i = order.size() - 1; i > 0 && mResources[order[i - 1]].firstPass > mResources[order[i]].firstPass; --i)
+		{
+			std::swap(order[i - 1], order[i]);
+		}
+	}
+
+	double requestedBytes = 0.0;
+	bool grew = false;
+	for (Handle r : order)
+	{
+		Resource& resource = mResources[r];
+		requestedBytes += TargetBytes(resource.desc);
+		int slot = -1;
+		for (int p = 0; p < static_cast<int>(mPool.size()); ++p)
+		{
+			if (mPool[p].target.desc == resource.desc && mPool[p].busyUntil < resource.firstPass)
+			{
+				slot = p;
+				break;
+			}
+		}
+		if (slot < 0)
+		{
+			PooledTarget pooled;
+			pooled.target = CreatePooledTarget(resource.desc);
+			mPool.push_back(pooled);
+			slot = static_cast<int>(mPool.size() - 1);
+			grew = true;
+		}
+		mPool[slot].busyUntil = resource.lastPass;
+		mPool[slot].lastUsedFrame = mFrame;
+		resource.slot = slot;
+		resource.target = mPool[slot].target;
+	}
+
+	if (grew)
+	{
+		double pooledBytes = 0.0;
+		for (const PooledTarget& pooled : mPool) pooledBytes += TargetBytes(pooled.target.desc);
+		LOG_INFO(std::format("Render graph pool: {} targets, {:.1f} MB ({:.1f} MB requested this frame)",
+			mPool.size(), pooledBytes / (1024.0 * 1024.0), requestedBytes / (1024.0 * 1024.0)));
+	}
+}
+
+void RenderGraph::Invalidate(const Resource& resource)
+{
+	const RenderTarget& target = resource.target;
+	if (!target.fb.id) return;
+	GLenum attachments[3];
+	GLsizei count = 0;
+	if (target.fb.colorTarget) attachments[count++] = GL_COLOR_ATTACHMENT0;
+	if (target.velocity) attachments[count++] = GL_COLOR_ATTACHMENT1;
+	if (target.fb.depthStencilTarget) attachments[count++] = GL_DEPTH_STENCIL_ATTACHMENT;
+	if (count > 0)
+	{
+		glInvalidateNamedFramebufferData(target.fb.id, count, attachments);
+	}
+}
+
+void RenderGraph::PollTimers()
+{
+	for (auto& [name, timer] : mTimers)
+	{
+		if (!timer.pending) continue;
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(timer.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) continue;
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(timer.queries[0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(timer.queries[1], GL_QUERY_RESULT, &end);
+		timer.ms = (end - begin) / 1.0e6;
+		timer.pending = false;
+	}
+}
+
+RenderTarget RenderGraph::CreatePooledTarget(const RenderTargetDesc& desc)
+{
+	RenderTarget target;
+	target.desc = desc;
+	target.fb = Buffer::CreateFrameBuffer(desc.width, desc.height, desc.samples, desc.colorFormat, desc.depthFormat);
+	if (desc.velocity)
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &target.velocity);
+		glTextureStorage2D(target.velocity, 1, GL_RG16F, desc.width, desc.height);
+		glNamedFramebufferTexture(target.fb.id, GL_COLOR_ATTACHMENT1, target.velocity, 0);
+		const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+		glNamedFramebufferDrawBuffers(target.fb.id, 2, drawBuffers);
+	}
+	return target;
+}
+
+void RenderGraph::DeletePooledTarget(RenderTarget& target)
+{
+	Buffer::DeleteFrameBuffer(target.fb);
+	if (target.velocity)
+	{
+		glDeleteTextures(1, &target.velocity);
+		target.velocity = 0;
+	}
+}
+
+double RenderGraph::TargetBytes(const RenderTargetDesc& desc)
+{
+	const double pixels = double(desc.width) * desc.height;
+	const double samples = desc.samples > 0 ? desc.samples : 1;
+	return pixels * samples * (FormatBytes(desc.colorFormat) + FormatBytes(desc.depthFormat)) + (desc.velocity ? pixels * 4.0 : 0.0);
+}
@@ -0,0 +1,157 @@
+#pragma once
+#ifndef __RENDERGRAPH_H__
+#define __RENDERGRAPH_H__
+#include <glad/glad.h>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Buffer.h"
+#include "FrameArena.h"
+
+// 渲染目标的描述：颜色、深度模板与可选的运动向量附件，描述相同的临时目标可以共用同一组显存
+struct RenderTargetDesc
+{
+	int width = 0;
+	int height = 0;
+	int samples = 0;
+	GLenum colorFormat = GL_NONE;
+	GLenum depthFormat = GL_NONE;
+	bool velocity = false;				// COLOR1 为 RG16F 运动向量（TAA）
+	bool operator==(const RenderTargetDesc& other) const = default;
+};
+
+struct RenderTarget
+{
+	FrameBuffer fb;
+	GLuint velocity = 0;
+	RenderTargetDesc desc;
+};
+
+// 帧图：每帧重新声明通道及其读写的渲染目标，Execute 时
+// 1. 剔除输出没有被任何有效通道读取的通道（写入导入目标或标记副作用的通道是根）；
+// 2. 按有效通道计算每个临时目标的生命周期，生命周期不重叠且描述相同的目标共用池中的同一组显存，
+//    池中连续 gRenderGraphEvictFrames 帧没有使用的目标被释放；
+// 3. 按声明顺序执行通道，临时目标在最后一次使用之后由 glInvalidateNamedFramebufferData 丢弃内容；
+// 4. 每个通道用时间戳查询计时，结果滞后几帧读取，不会等待 GPU。
+// 通道的读写列表与执行函数分配在帧分配器中，稳态帧不访问通用堆。
+class RenderGraph
+{
+public:
+	using Handle = int;
+
+	class PassBuilder
+	{
+	public:
+		void Read(Handle target);
+		void Write(Handle target);
+		// 通道有图之外可见的效果（例如更新缓存的阴影图），不会被剔除
+		void SideEffect();
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph& graph, int pass) : mGraph(graph), mPass(pass) {}
+		RenderGraph& mGraph;
+		int mPass;
+	};
+
+	RenderGraph();
+	~RenderGraph();
+
+	// 本帧的临时目标，由图分配，只在读写它的通道执行期间有效；name 为字符串常量
+	Handle CreateTarget(const char* name, const RenderTargetDesc& desc);
+	// 图之外持有的目标（历史帧、呈现目标），不会被分配或丢弃内容
+	Handle ImportTarget(const char* name, const RenderTarget& target);
+
+	 /********************************************************************************
+	 * @brief		声明一个通道
+	 *********************************************************************************
+	 * @param		name 通道名称，字符串常量，同名通道共用计时结果
+	 * @param		setup 立即调用，声明通道读写的目标
+	 * @param		execute 通道有效时在 Execute 中调用；复制到帧分配器中，不会被析构，
+	 *				只能按值捕获可平凡析构的对象（句柄、数值）或引用
+	 ********************************************************************************/
+	template<typename Setup, typename Execute>
+	void AddPass(const char* name, Setup&& setup, Execute&& execute)
+	{
+		using Function = std::decay_t<Execute>;
+		static_assert(std::is_trivially_destructible_v<Function>, "Render graph passes must not own resources");
+		Pass pass;
+		pass.name = name;
+		pass.execute = new (FrameArena::Allocate(sizeof(Function), alignof(Function))) Function(std::forward<Execute>(execute));
+		pass.invoke = [](void* function) { (*static_cast<Function*>(function))(); };
+		mPasses.push_back(pass);
+		PassBuilder builder(*this, static_cast<int>(mPasses.size() - 1));
+		setup(builder);
+	}
+
+	// 通道执行期间取得已声明的目标
+	const RenderTarget& Get(Handle target) const;
+
+	// 编译并执行本帧声明的通道，之后清空声明，保留目标池与计时
+	void Execute();
+
+	// 最近一次执行的图（通道、目标、生命周期、共用的显存槽位与每个通道的 GPU 时间），Graphviz DOT 格式；
+	// 在下一次 Execute 之前调用
+	std::string ExportDot() const;
+
+	// 释放目标池与计时查询
+	void Delete();
+
+private:
+	struct Resource
+	{
+		const char* name = nullptr;
+		RenderTargetDesc desc;
+		bool imported = false;
+		RenderTarget target;			// 导入的目标，或执行期间分配到的池中目标
+		int slot = -1;					// 池中的槽位
+		int firstPass = -1;				// 有效通道中的生命周期
+		int lastPass = -1;
+	};
+
+	struct Pass
+	{
+		const char* name = nullptr;
+		FrameVector<Handle> reads;
+		FrameVector<Handle> writes;
+		void* execute = nullptr;			// 帧分配器中的执行函数
+		void (*invoke)(void*) = nullptr;
+		bool sideEffect = false;
+		bool culled = false;
+	};
+
+	struct PooledTarget
+	{
+		RenderTarget target;
+		uint64_t lastUsedFrame = 0;
+		int busyUntil = -1;				// 本帧中被占用到第几个通道
+	};
+
+	struct PassTimer
+	{
+		GLuint queries[2] = { 0, 0 };
+		bool pending = false;
+		double ms = 0.0;
+	};
+
+	void Cull();
+	void Allocate();
+	void Invalidate(const Resource& resource);
+	void PollTimers();
+	static RenderTarget CreatePooledTarget(const RenderTargetDesc& desc);
+	static void DeletePooledTarget(RenderTarget& target);
+	static double TargetBytes(const RenderTargetDesc& desc);
+
+	std::vector<Resource> mResources;
+	std::vector<Pass> mPasses;
+	std::vector<Resource> mLastResources;	// 最近一次执行的图，读写列表在帧分配器中保留到下一帧
+	std::vector<Pass> mLastPasses;
+	std::vector<PooledTarget> mPool;
+	std::map<std::string, PassTimer, std::less<>> mTimers;
+	uint64_t mFrame;
+};
+
+#endif // !__RENDERGRAPH_H__
@@ -1,8 +1,17 @@
 #include <iostream>
 #include <memory>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
+#include <glm/gtx/component_wise.hpp>
+#include <glm/gtx/color_space.hpp>
+#include <glm/gtc/constants.hpp>
 #include <GLFW/glfw3.h>
 
 #include "Mesh.h"
@@ -13,6 +22,8 @@
 #include "Shader.h"
 #include "Log.h"
 #include "Path.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
 #include <glm/gtc/type_ptr.hpp>
 
 struct TransformUB
@@ -20,8 +31,47 @@ struct TransformUB
 	glm::mat4 viewProjectionMatrix;
 	glm::mat4 skyProjectionMatrix;
 	glm::mat4 sceneRotationMatrix;
+	glm::mat4 prevViewProjectionMatrix;
+	glm::mat4 prevSkyProjectionMatrix;
+	glm::mat4 prevSceneRotationMatrix;
+	glm::vec4 jitter;					// xy 为当前帧抖动，zw 为上一帧抖动（NDC 单位）
 };
 
+// 与 clustered_lights.glsl 中的 LocalLight 一致
+struct LocalLightSB
+{
+	glm::vec4 positionRange;
+	glm::vec4 radianceCosInner;
+	glm::vec4 directionCosOuter;
+};
+
+// 与 clustered_lights.glsl 中的 ClusterUniforms 一致
+struct ClusterUB
+{
+	glm::mat4 viewMatrix;
+	glm::mat4 projectionMatrix;
+	glm::mat4 inverseProjectionMatrix;
+	glm::uvec4 grid;					// xyz 为簇网格尺寸，w 为局部光源数量
+	glm::vec4 depth;					// 近平面、远平面、深度分层的比例与偏移
+};
+
+// 投影的近平面与远平面，分簇光照按同样的范围划分深度
+static constexpr float kNearPlane = 1.0f;
+static constexpr float kFarPlane = 1000.0f;
+static constexpr int kNumClusters = gClusterGridX * gClusterGridY * gClusterGridZ;
+
+// 与 shadows.glsl 中的 ShadowUniforms 一致
+struct ShadowUB
+{
+	glm::mat4 matrices[SceneSettings::NumLights * 4];
+	glm::vec4 cascadeSplits;
+	glm::vec4 cascadeTexelSizes;
+	glm::uvec4 params;					// x 为级联数量，0 表示不使用阴影
+	glm::uvec4 lightLayers;				// 第 i 个启用光源的起始层（场景光源序号 * 级联数量）
+};
+static_assert(SceneSettings::NumLights <= 4, "ShadowUB::lightLayers holds one layer per light");
+static_assert(gShadowCascades >= 1 && gShadowCascades <= 4, "gShadowCascades must match MaxShadowCascades in shadows.glsl");
+
 struct ShadingUB
 {
 	struct {
@@ -31,6 +81,96 @@ struct ShadingUB
 	glm::vec4 eyePosition;
 };
 
+// 预计算着色器变体：样本数量为 0 的着色器不需要 NUM_SAMPLES
+static ShaderDefines PrecomputeVariant(int numSamples = 0)
+{
+	ShaderDefines defines = {
+		{"GROUP_SIZE_X", gComputeGroupSize},
+		{"GROUP_SIZE_Y", gComputeGroupSize},
+	};
+	if (numSamples > 0)
+	{
+		defines["NUM_SAMPLES"] = numSamples;
+	}
+	return defines;
+}
+
+// 色调映射着色器变体：MSAA_SAMPLES 大于 0 时从 sampler2DMS 逐样本读取（融合解析）。
+// 不融合时不定义任何宏，仍然可以使用离线 SPIR-V 模块
+static ShaderDefines TonemapVariant(int sceneSamples)
+{
+	if (gFusedResolve && gAntiAliasing == AntiAliasing::MSAA && sceneSamples > 0)
+	{
+		return { {"MSAA_SAMPLES", sceneSamples} };
+	}
+	return {};
+}
+
+// 帧图之外持有的单样本目标（TAA 历史帧、呈现目标），每帧作为导入目标参与帧图
+static RenderTarget CreatePersistentTarget(int width, int height, GLenum colorFormat)
+{
+	RenderTarget target;
+	target.desc.width = width;
+	target.desc.height = height;
+	target.desc.colorFormat = colorFormat;
+	target.fb = Buffer::CreateFrameBuffer(width, height, 0, colorFormat, GL_NONE);
+	return target;
+}
+
+// PBR 着色器变体：按启用的光源数量、功能开关和顶点输入方式特化
+static ShaderDefines PbrVariant(int numLights, bool vertexPulling = gVertexPulling)
+{
+	return {
+		{"NUM_LIGHTS", numLights},
+		{"ENABLE_IBL", gEnableIBL ? 1 : 0},
+		{"ENABLE_NORMAL_MAP", gEnableNormalMap ? 1 : 0},
+		{"VERTEX_PULLING", vertexPulling ? 1 : 0},
+	};
+}
+
+
+// 可见性缓冲区着色程序的变体：与 PBR 片元程序相同的光源数量和功能开关，没有顶点输入方式
+static ShaderDefines VisibilityShadeVariant(int numLights)
+{
+	ShaderDefines defines = PbrVariant(numLights);
+	defines.erase("VERTEX_PULLING");
+	return defines;
+}
+
+// Halton 低差异序列，用于 TAA 的子像素抖动
+static float Halton(int index, int base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f;
+	for (; index > 0; index /= base)
+	{
+		fraction /= base;
+		result += fraction * (index % base);
+	}
+	return result;
+}
+
+// 场景颜色目标的格式及其每像素字节数
+static GLenum SceneColorFormat(ColorQuality quality)
+{
+	return quality == ColorQuality::High ? GL_RGBA16F : GL_R11F_G11F_B10F;
+}
+
+static double ColorFormatBytes(GLenum format)
+{
+	return format == GL_RGBA16F ? 8.0 : 4.0;
+}
+
+// 与 tonemap.frag 相同的色调映射和 Gamma 校正，量化为 8 位输出
+static glm::ivec3 TonemapToDisplay(glm::vec3 color)
+{
+	const float gamma = 2.2f, pureWhite = 1.0f;
+	const float luminance = glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+	const float mappedLuminance = (luminance * (1.0f + luminance / (pureWhite * pureWhite))) / (1.0f + luminance);
+	const glm::vec3 mappedColor = luminance > 0.0f ? (mappedLuminance / luminance) * color : glm::vec3(0.0f);
+	return glm::ivec3(glm::round(glm::clamp(glm::pow(mappedColor, glm::vec3(1.0f / gamma)), 0.0f, 1.0f) * 255.0f));
+}
+
 
 GLFWwindow* Renderer::Init()
 {
@@ -66,14 +206,40 @@ GLFWwindow* Renderer::Init()
 	glGetIntegerv(GL_MAX_SAMPLES, &maxSupportedSamples);
 
 	const int samples = glm::min(gDisplaySamples, maxSupportedSamples);
-	mFreameBuffer = Buffer::CreateFrameBuffer(gDisplaySizeX, gDisplaySizeY, samples, GL_RGBA16F, GL_DEPTH24_STENCIL8);
-	if (samples > 0) 
+	// 开启动态分辨率时按最大比例分配渲染目标，之后只改变视口，不再重新分配
+	mRenderScale = gDynamicResolution ? gMaxRenderScale : (gAntiAliasing == AntiAliasing::TAA ? gRenderScale : 1.0f);
+	const int width = int(gDisplaySizeX * mRenderScale);
+	const int height = int(gDisplaySizeY * mRenderScale);
+	const GLenum colorFormat = SceneColorFormat(gColorQuality);
+	// 场景、解析与可见性缓冲区目标是帧图的临时目标，第一次使用时从池中分配
+	// TAA：单样本的场景目标（内部分辨率）+ 运动向量，两张显示分辨率的历史目标交替读写
+	mSceneDesc.width = width;
+	mSceneDesc.height = height;
+	mSceneDesc.samples = gAntiAliasing == AntiAliasing::TAA ? 0 : samples;
+	mSceneDesc.colorFormat = colorFormat;
+	mSceneDesc.depthFormat = GL_DEPTH24_STENCIL8;
+	mSceneDesc.velocity = gAntiAliasing == AntiAliasing::TAA;
+	if (gAntiAliasing == AntiAliasing::TAA)
+	{
+		for (RenderTarget& history : mHistoryTargets)
+		{
+			history = CreatePersistentTarget(gDisplaySizeX, gDisplaySizeY, colorFormat);
+		}
+	}
+	if (gOnDemandRendering)
 	{
-		mResolveFramebuffer = Buffer::CreateFrameBuffer(gDisplaySizeX, gDisplaySizeY, 0, GL_RGBA16F, GL_NONE);
+		mPresentTarget = CreatePersistentTarget(gDisplaySizeX, gDisplaySizeY, GL_RGBA8);
 	}
-	else {
-		mResolveFramebuffer = mFreameBuffer;
+	else
+	{
+		// 直接写入默认帧缓冲
+		mPresentTarget.desc.width = gDisplaySizeX;
+		mPresentTarget.desc.height = gDisplaySizeY;
+		mPresentTarget.desc.colorFormat = GL_RGBA8;
 	}
+	LogRenderTargetBudget(samples);
+	mFrameTimer.Init();
+	mFramePacer.Init(gMaxFramesInFlight);
 
 	//LOG_INFO("OpenGL 4.5 Renderer"+ glGetString(GL_RENDERER));
 	std::printf("OpenGL 4.5 Renderer [%s]\n", glGetString(GL_RENDERER));
@@ -91,71 +257,239 @@ void Renderer::Load()
 	// 创建统一缓冲区
 	mTransformUB = Buffer::CreateUniformBuffer<TransformUB>();
 	mShadingUB = Buffer::CreateUniformBuffer<ShadingUB>();
+	mClusterUB = Buffer::CreateUniformBuffer<ClusterUB>();
+	mShadowUB = Buffer::CreateUniformBuffer<ShadowUB>();
+
+	// 分簇光照的存储缓冲区
+	mLocalLightSB = Buffer::CreateStorageBuffer(nullptr, gMaxLocalLights * sizeof(LocalLightSB));
+	mClusterLightCounts = Buffer::CreateStorageBuffer(nullptr, kNumClusters * sizeof(GLuint));
+	mClusterLightIndices = Buffer::CreateStorageBuffer(nullptr, size_t(kNumClusters) * gClusterMaxLights * sizeof(GLuint));
+
+	// 先批量提交全部着色器程序，驱动的编译线程在加载网格和纹理的同时并行编译，
+	// 之后的 LinkProgram/GetProgramVariant 只取回结果
+	Shader::PrefetchProgram({ "tonemap.vert","tonemap.frag" }, TonemapVariant(mSceneDesc.samples));
+	if (gAntiAliasing == AntiAliasing::TAA)
+	{
+		Shader::PrefetchProgram({ "tonemap.vert","taa.frag" });
+	}
+	Shader::PrefetchProgram({ "skybox.vert","skybox.frag" });
+	if (gDepthPrepass != DepthPrepass::Off)
+	{
+		Shader::PrefetchProgram({ "depth.vert" });
+	}
+	for (int numLights = 0; numLights <= SceneSettings::NumLights; ++numLights)
+	{
+		Shader::PrefetchProgram({ "pbr.vert","pbr.frag" }, PbrVariant(numLights));
+	}
+	Shader::PrefetchProgram({ "visibility.vert","visibility.frag" });
+	for (int numLights = 0; numLights <= SceneSettings::NumLights; ++numLights)
+	{
+		Shader::PrefetchProgram({ "visibility.comp" }, VisibilityShadeVariant(numLights));
+	}
+	Shader::PrefetchProgram({ "cluster.comp" });
+	Shader::PrefetchProgram({ "shadow.vert" });
+	Shader::PrefetchProgram({ "equirect2cube.comp" }, PrecomputeVariant());
+	Shader::PrefetchProgram({ "spmap.comp" }, PrecomputeVariant(gSpecularSamples));
+	Shader::PrefetchProgram({ "irmap.comp" }, PrecomputeVariant(gIrradianceSamples));
+	Shader::PrefetchProgram({ "spbrdf.comp" }, PrecomputeVariant(gBRDFSamples));
+
+	// 网格导入与图像解码作为任务并行执行，与后台的着色器编译重叠；GL 资源随后在本线程创建
+	JobCounter assetsLoaded;
+	std::shared_ptr<Mesh> skyboxMesh, pbrMesh;
+	std::shared_ptr<Image> environmentImage;
+	JobSystem::Run("Load mesh", [&]() { skyboxMesh = Mesh::ReadFile("meshes/skybox.obj"); }, &assetsLoaded);
+	JobSystem::Run("Load mesh", [&]() { pbrMesh = Mesh::ReadFile("meshes/pbr.fbx"); }, &assetsLoaded);
+	JobSystem::Run("Decode image", [&]() { environmentImage = Image::ReadFile("environment.hdr", 3); }, &assetsLoaded);
+
+	// 材质纹理经由资源管理器加载：解码任务与上面的任务并行，共用同一贴图的材质只上传一次
+	mResources.Init(gTextureBudget);
+	const TextureRequest materialRequests[4] = {
+		{ "textures/pbrA.png", 3, GL_RGB, GL_SRGB8 },
+		{ "textures/pbrN.png", 3, GL_RGB, GL_RGB8 },
+		{ "textures/pbrM.png", 1, GL_RED, GL_R8 },
+		{ "textures/pbrR.png", 1, GL_RED, GL_R8 },
+	};
+	const std::vector<TextureHandle> materialTextures = mResources.LoadTextures(materialRequests);
+	mAlbedoTexture = materialTextures[0];
+	mNormalTexture = materialTextures[1];
+	mMetalnessTexture = materialTextures[2];
+	mRoughnessTexture = materialTextures[3];
+	JobSystem::Wait(assetsLoaded);
+
+	mSkybox = Buffer::CreateMeshBuffer(skyboxMesh);
+	// 顶点拉取路径把压缩顶点放入网格缓冲区池，可见性缓冲区路径也从中重建三角形；对比测试需要两条路径同时存在
+	if (!gVertexPulling || gRunBenchmarks)
+	{
+		mPbrModel = Buffer::CreateMeshBuffer(pbrMesh);
+	}
+	mMeshArena = Buffer::CreateMeshArena(static_cast<GLuint>(pbrMesh->mVertices.size()), static_cast<GLuint>(pbrMesh->mTriangle.size()) * 3);
+	mPbrModelPulled = Buffer::AllocateMeshBuffer(mMeshArena, pbrMesh);
+	// 可见性缓冲区的三角形编号占 24 位，0 表示没有几何
+	LOG_ASSERT(pbrMesh->mTriangle.size() >= (1u << 24) - 1, "Too many triangles for the visibility buffer");
+	// 深度预通道的位置顶点流与 PBR 通道共用索引
+	if (gDepthPrepass != DepthPrepass::Off)
+	{
+		mPbrDepthModel = gVertexPulling
+			? Buffer::CreatePositionBuffer(pbrMesh, mMeshArena.indexBuffer, mPbrModelPulled.firstIndex)
+			: Buffer::CreatePositionBuffer(pbrMesh, mPbrModel.ibo);
+	}
+	// 绘制队列的每个 VAO 都以属性 15 提供记录序号
+	LOG_ASSERT(gModelGrid * gModelGrid > 256, "Too many models for the visibility buffer instance bits");
+	mDrawQueue.Init(gMaxDraws);
+	for (GLuint vao : { mMeshArena.vao, mPbrModel.vao, mPbrDepthModel.vao })
+	{
+		if (vao) mDrawQueue.AttachDrawIndex(vao);
+	}
 
-	mTonemapProgram = Shader::LinkProgram({ "tonemap.vert","tonemap.frag" });
 
-	mSkybox = Buffer::CreateMeshBuffer(Mesh::ReadFile("meshes/skybox.obj"));
+	mTonemapProgram = Shader::LinkProgram({ "tonemap.vert","tonemap.frag" }, TonemapVariant(mSceneDesc.samples));
 	mSkyboxProgram = Shader::LinkProgram({ "skybox.vert","skybox.frag" });
+	Shader::WatchProgram(mTonemapProgram, { "tonemap.vert","tonemap.frag" }, TonemapVariant(mSceneDesc.samples));
+	Shader::WatchProgram(mSkyboxProgram, { "skybox.vert","skybox.frag" });
+	mVisibilityProgram = Shader::LinkProgram({ "visibility.vert","visibility.frag" });
+	Shader::WatchProgram(mVisibilityProgram, { "visibility.vert","visibility.frag" });
+	if (gShadows)
+	{
+		// 深度比较纹理，线性过滤由硬件做 2x2 PCF
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &mShadowTexture);
+		glTextureStorage3D(mShadowTexture, 1, GL_DEPTH_COMPONENT32F, gShadowMapSize, gShadowMapSize, SceneSettings::NumLights * gShadowCascades);
+		glTextureParameteri(mShadowTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(mShadowTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(mShadowTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(mShadowTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(mShadowTexture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTextureParameteri(mShadowTexture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		glCreateFramebuffers(1, &mShadowFramebuffer);
+		glNamedFramebufferDrawBuffer(mShadowFramebuffer, GL_NONE);
+		glNamedFramebufferReadBuffer(mShadowFramebuffer, GL_NONE);
+		mShadowProgram = Shader::LinkProgram({ "shadow.vert" });
+		Shader::WatchProgram(mShadowProgram, { "shadow.vert" });
+		LOG_INFO(std::format("Shadow maps: {} lights x {} cascades at {}x{}, {:.1f} MB", SceneSettings::NumLights, gShadowCascades,
+			gShadowMapSize, gShadowMapSize, double(gShadowMapSize) * gShadowMapSize * 4.0 * SceneSettings::NumLights * gShadowCascades / (1024.0 * 1024.0)));
+	}
+	mClusterProgram = Shader::LinkProgram({ "cluster.comp" });
+	Shader::WatchProgram(mClusterProgram, { "cluster.comp" });
+	if (gDepthPrepass != DepthPrepass::Off)
+	{
+		mDepthProgram = Shader::LinkProgram({ "depth.vert" });
+		Shader::WatchProgram(mDepthProgram, { "depth.vert" });
+	}
+	if (gDepthPrepass == DepthPrepass::Auto)
+	{
+		glCreateQueries(GL_SAMPLES_PASSED, 1, &mOverdrawQuery);
+	}
+	if (gAntiAliasing == AntiAliasing::TAA)
+	{
+		mTaaProgram = Shader::LinkProgram({ "tonemap.vert","taa.frag" });
+		Shader::WatchProgram(mTaaProgram, { "tonemap.vert","taa.frag" });
+	}
 
-	mPbrModel = Buffer::CreateMeshBuffer(Mesh::ReadFile("meshes/pbr.fbx"));
-	mPbrProgram = Shader::LinkProgram({ "pbr.vert","pbr.frag" });
-
-	mAlbedoTexture = Texture("textures/pbrA.png", 3, GL_RGB, GL_SRGB8);
-	mNormalTexture = Texture("textures/pbrN.png", 3, GL_RGB, GL_RGB8);
-	mMetalnessTexture = Texture("textures/pbrM.png", 1, GL_RED, GL_R8);
-	mRoughnessTexture = Texture("textures/pbrR.png", 1, GL_RED, GL_R8);
+	// 预先生成 0~NumLights 个光源的全部变体，切换光源时只需切换程序
+	for (int numLights = 0; numLights <= SceneSettings::NumLights; ++numLights)
+	{
+		Shader::GetProgramVariant({ "pbr.vert","pbr.frag" }, PbrVariant(numLights));
+	}
+	mPbrProgram = Shader::GetProgramVariant({ "pbr.vert","pbr.frag" }, PbrVariant(SceneSettings::NumLights));
+	mPbrLightCount = SceneSettings::NumLights;
 
-	Texture envTextureUnfiltered = LoadAndConvertEquirectangularToCubemap();
+	Texture envTextureUnfiltered = LoadAndConvertEquirectangularToCubemap(*environmentImage);
 	mEnvTexture = ComputePreFilteredSpecularMap(envTextureUnfiltered, gEnvMapSize);
 	glDeleteTextures(1, &envTextureUnfiltered.mId);
 	mIrmapTexture = ComputeDiffuseIrradianceCubemap(mEnvTexture, gIrradianceMapSize);
 	mSpBRDF_LUT = ComputeCookTorranceBRDF_LUT(gBRDF_LUT_Size);
 
 	glFinish();
+	Shader::LogCacheStatistics();
+	mResources.LogStatistics();
+	JobSystem::ReportStats("Load");
 }
 
 void Renderer::Clear()
 {
-	if(mFreameBuffer.id != mResolveFramebuffer.id) 
+	mRenderGraph.Delete();
+	mFrameTimer.Delete();
+	mFramePacer.Delete();
+	for (RenderTarget& history : mHistoryTargets)
 	{
-		Buffer::DeleteFrameBuffer(mResolveFramebuffer);
+		if (history.fb.id) Buffer::DeleteFrameBuffer(history.fb);
 	}
-	Buffer::DeleteFrameBuffer(mFreameBuffer);
+	if (mPresentTarget.fb.id) Buffer::DeleteFrameBuffer(mPresentTarget.fb);
 
 	glDeleteVertexArrays(1, &mEmptyVAO);
 
 	glDeleteBuffers(1, &mTransformUB);
 	glDeleteBuffers(1, &mShadingUB);
+	glDeleteBuffers(1, &mClusterUB);
+	glDeleteBuffers(1, &mShadowUB);
+	glDeleteBuffers(1, &mLocalLightSB);
+	glDeleteBuffers(1, &mClusterLightCounts);
+	glDeleteBuffers(1, &mClusterLightIndices);
 
 	Buffer::DeleteMeshBuffer(mSkybox);
 	Buffer::DeleteMeshBuffer(mPbrModel);
+	Buffer::DeleteMeshBuffer(mPbrDepthModel);
+	Buffer::DeleteMeshArena(mMeshArena);
+	mDrawQueue.Delete();
 	
+	Shader::UnwatchPrograms();
 	glDeleteProgram(mTonemapProgram);
+	if (mTaaProgram) glDeleteProgram(mTaaProgram);
+	if (mDepthProgram) glDeleteProgram(mDepthProgram);
+	if (mOverdrawQuery) glDeleteQueries(1, &mOverdrawQuery);
 	glDeleteProgram(mSkyboxProgram);
-	glDeleteProgram(mPbrProgram);
+	glDeleteProgram(mClusterProgram);
+	glDeleteProgram(mVisibilityProgram);
+	if (mShadowProgram)
+	{
+		glDeleteProgram(mShadowProgram);
+		glDeleteFramebuffers(1, &mShadowFramebuffer);
+		glDeleteTextures(1, &mShadowTexture);
+		LOG_INFO(std::format("Shadow cache: {} cascade renders, {:.1f}% of re-rendering every cascade each frame",
+			mShadowCascadeRenders, mShadowCascadeSlots ? 100.0 * mShadowCascadeRenders / mShadowCascadeSlots : 0.0));
+	}
+	Shader::DeleteProgramVariants();
 
 	mEnvTexture.DelTexture();
 	mIrmapTexture.DelTexture();
 	mSpBRDF_LUT.DelTexture();
-	mAlbedoTexture.DelTexture();
-	mNormalTexture.DelTexture();
-	mMetalnessTexture.DelTexture();
-	mRoughnessTexture.DelTexture();
+	mResources.Release(mAlbedoTexture);
+	mResources.Release(mNormalTexture);
+	mResources.Release(mMetalnessTexture);
+	mResources.Release(mRoughnessTexture);
+	mResources.Delete();
 }
 
 
-void Renderer::RenderFrame(GLFWwindow* window, const ViewSettings& view, const SceneSettings& scene)
+void Renderer::RenderFrame(GLFWwindow* window, const ViewSettings& view, const SceneSettings& scene, double inputTime)
 {
+	// 本帧的临时分配来自帧分配器；记录日志条数与堆分配次数，帧结束时检查稳态帧没有访问通用堆
+	FrameArena::BeginFrame();
+	const uint64_t heapAllocationsBefore = FrameArena::HeapAllocations();
+	const uint64_t logMessagesBefore = Log::MessageCount();
+	bool variantChanged = false;
 
-	// 创建一个简单的模型矩阵，并缩小为原来的一半
-	glm::mat4 model = glm::mat4(1.0f); // 初始化为单位矩阵，即无变换
-	model = glm::scale(model, glm::vec3(0.2f)); // 将模型缩小为原来的一半
-	
-	glUseProgram(mPbrProgram);
-	GLuint modelLoc = glGetUniformLocation(mPbrProgram, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	ReloadShaders();
 
-	const glm::mat4 projectionMatrix = glm::perspectiveFov(view.fov, float(mFreameBuffer.width), float(mFreameBuffer.height), 1.0f, 1000.0f);
+	// 动态分辨率：根据几帧之前的 GPU 时间决定本帧的渲染分辨率
+	if (gDynamicResolution)
+	{
+		UpdateDynamicResolution();
+	}
+	const int renderWidth = glm::clamp(int(gDisplaySizeX * mRenderScale), 1, mSceneDesc.width);
+	const int renderHeight = glm::clamp(int(gDisplaySizeY * mRenderScale), 1, mSceneDesc.height);
+	const glm::vec2 viewportScale = glm::vec2(renderWidth, renderHeight) / glm::vec2(mSceneDesc.width, mSceneDesc.height);
+	mFrameTimer.Begin();
+
+	// TAA 模式下每帧在像素内按 Halton(2,3) 序列抖动投影，平移量以 NDC 为单位
+	glm::vec2 jitter{ 0.0f };
+	if (gAntiAliasing == AntiAliasing::TAA)
+	{
+		const int phase = mFrameIndex % 8 + 1;
+		jitter = glm::vec2(Halton(phase, 2) - 0.5f, Halton(phase, 3) - 0.5f) * 2.0f / glm::vec2(renderWidth, renderHeight);
+	}
+	const glm::mat4 jitterMatrix = glm::translate(glm::mat4{ 1.0f }, glm::vec3(jitter, 0.0f));
+
+	const glm::mat4 projectionMatrix = jitterMatrix * glm::perspectiveFov(view.fov, float(renderWidth), float(renderHeight), kNearPlane, kFarPlane);
 	const glm::mat4 viewRotationMatrix = glm::eulerAngleXY(glm::radians(view.pitch), glm::radians(view.yaw));
 	const glm::mat4 sceneRotationMatrix = glm::eulerAngleXY(glm::radians(scene.pitch), glm::radians(scene.yaw));
 	const glm::mat4 viewMatrix = glm::translate(glm::mat4{ 1.0f }, { 0.0f, 0.0f, -view.distance }) * viewRotationMatrix;
@@ -167,79 +501,1142 @@ void Renderer::RenderFrame(GLFWwindow* window, const ViewSettings& view, const S
 		transformUniforms.viewProjectionMatrix = projectionMatrix * viewMatrix;
 		transformUniforms.skyProjectionMatrix  = projectionMatrix * viewRotationMatrix;
 		transformUniforms.sceneRotationMatrix  = sceneRotationMatrix;
+		// 第一帧没有上一帧，运动向量为 0
+		// 按需渲染：TAA 在画面静止后还需要若干帧收敛
+		mStillFrames = (mFrameIndex > 0 && viewMatrix == mViewMatrix && sceneRotationMatrix == mPrevSceneRotation) ? mStillFrames + 1 : 0;
+		if (mFrameIndex == 0)
+		{
+			mPrevViewProjection = transformUniforms.viewProjectionMatrix;
+			mPrevSkyProjection = transformUniforms.skyProjectionMatrix;
+			mPrevSceneRotation = sceneRotationMatrix;
+			mPrevJitter = jitter;
+		}
+		transformUniforms.prevViewProjectionMatrix = mPrevViewProjection;
+		transformUniforms.prevSkyProjectionMatrix  = mPrevSkyProjection;
+		transformUniforms.prevSceneRotationMatrix  = mPrevSceneRotation;
+		transformUniforms.jitter = glm::vec4(jitter, mPrevJitter);
 		glNamedBufferSubData(mTransformUB, 0, sizeof(TransformUB), &transformUniforms);
+		mInverseSkyProjection = glm::inverse(transformUniforms.skyProjectionMatrix);
+
+		mPrevViewProjection = transformUniforms.viewProjectionMatrix;
+		mPrevSkyProjection = transformUniforms.skyProjectionMatrix;
+		mPrevSceneRotation = sceneRotationMatrix;
+		mPrevJitter = jitter;
 	}
 
 	// 更新着色统一缓冲区
+	// 启用的光源紧凑排列在数组前部，PBR 着色器变体只遍历这些光源
 	{
 		ShadingUB shadingUniforms;
 		shadingUniforms.eyePosition = glm::vec4(eyePosition, 0.0f);
+		int numLights = 0;
 		for(int i=0; i<SceneSettings::NumLights; ++i) 
 		{
 			const SceneSettings::Light& light = scene.lights[i];
-			shadingUniforms.lights[i].direction = glm::vec4{light.direction, 0.0f};
-			if(light.enabled) 
-				shadingUniforms.lights[i].radiance = glm::vec4{light.radiance, 0.0f};
-			else 
-				shadingUniforms.lights[i].radiance = glm::vec4{};
+			if(!light.enabled) continue;
+			shadingUniforms.lights[numLights].direction = glm::vec4{light.direction, 0.0f};
+			shadingUniforms.lights[numLights].radiance = glm::vec4{light.radiance, 0.0f};
+			++numLights;
 		}
 		glNamedBufferSubData(mShadingUB, 0, sizeof(ShadingUB), &shadingUniforms);
+
+		// 簇的构建使用本帧的视图与投影矩阵
+		mViewMatrix = viewMatrix;
+		mProjectionMatrix = projectionMatrix;
+
+		if(numLights != mPbrLightCount)
+		{
+			if (mRenderPath == RenderPath::VisibilityBuffer)
+			{
+				mVisibilityShadeProgram = Shader::GetProgramVariant({ "visibility.comp" }, VisibilityShadeVariant(numLights));
+				// 融合解析的色调映射读取多采样目标，可见性缓冲区的结果是单样本的
+				mVisibilityTonemapProgram = TonemapVariant(mSceneDesc.samples).empty()
+					? mTonemapProgram : Shader::GetProgramVariant({ "tonemap.vert","tonemap.frag" }, {});
+			}
+			mPbrProgram = Shader::GetProgramVariant({ "pbr.vert","pbr.frag" }, PbrVariant(numLights));
+			mPbrLightCount = numLights;
+			variantChanged = true;
+		}
 	}
 
-	// 准备用于渲染的帧缓冲
-	glBindFramebuffer(GL_FRAMEBUFFER, mFreameBuffer.id);
-	// 无需清除颜色，因为我们将用天空盒覆盖屏幕。
-	glClear(GL_DEPTH_BUFFER_BIT);
-	
+	// 本帧的绘制按状态排序、合并，各通道从队列提交
+	QueueSceneDraws(sceneRotationMatrix, eyePosition);
+
 	// 绑定统一缓冲区
 	glBindBufferBase(GL_UNIFORM_BUFFER, 0, mTransformUB);
 	glBindBufferBase(GL_UNIFORM_BUFFER, 1, mShadingUB);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 3, mShadowUB);
+
+	// 帧图：声明本帧的通道及其读写的目标，Execute 剔除无用的通道、分配临时目标并依次执行
+	// 局部光源分配到簇、更新缓存的阴影图，着色通道读取结果
+	mRenderGraph.AddPass("LightClusters", [](RenderGraph::PassBuilder& pass) { pass.SideEffect(); },
+		[this, &scene]() {
+			UploadLocalLights(scene.localLights);
+			BuildLightClusters();
+		});
+	mRenderGraph.AddPass("ShadowMaps", [](RenderGraph::PassBuilder& pass) { pass.SideEffect(); },
+		[this, &scene, &sceneRotationMatrix]() { UpdateShadowMaps(scene, sceneRotationMatrix); });
+
+	// 场景通道，sceneColor 为之后 TAA 与色调映射读取的 HDR 颜色
+	const bool visibilityBuffer = mRenderPath == RenderPath::VisibilityBuffer;
+	RenderGraph::Handle sceneColor;
+	if (visibilityBuffer)
+	{
+		// 可见性缓冲区的着色结果是单样本的，没有深度；天空由着色程序写入
+		RenderTargetDesc visibilityDesc = mSceneDesc;
+		visibilityDesc.samples = 0;
+		visibilityDesc.colorFormat = GL_R32UI;
+		visibilityDesc.velocity = false;
+		RenderTargetDesc colorDesc = mSceneDesc;
+		colorDesc.samples = 0;
+		colorDesc.depthFormat = GL_NONE;
+		const RenderGraph::Handle visibility = mRenderGraph.CreateTarget("Visibility", visibilityDesc);
+		sceneColor = mRenderGraph.CreateTarget("SceneColor", colorDesc);
+		mRenderGraph.AddPass("VisibilityRaster", [&](RenderGraph::PassBuilder& pass) { pass.Write(visibility); },
+			[this, renderWidth, renderHeight, visibility]() {
+				RasterizeVisibility(renderWidth, renderHeight, mRenderGraph.Get(visibility));
+			});
+		mRenderGraph.AddPass("VisibilityShade", [&](RenderGraph::PassBuilder& pass) { pass.Read(visibility); pass.Write(sceneColor); },
+			[this, renderWidth, renderHeight, visibility, sceneColor]() {
+				ShadeVisibility(renderWidth, renderHeight, mRenderGraph.Get(visibility), mRenderGraph.Get(sceneColor));
+			});
+	}
+	else
+	{
+		const RenderGraph::Handle sceneTarget = mRenderGraph.CreateTarget("Scene", mSceneDesc);
+		// 对比测试在第一个前向渲染的帧中运行
+		mRenderGraph.AddPass("ForwardScene", [&](RenderGraph::PassBuilder& pass) { pass.Write(sceneTarget); },
+			[this, &scene, renderWidth, renderHeight, sceneTarget]() {
+				const RenderTarget& target = mRenderGraph.Get(sceneTarget);
+				RenderForward(renderWidth, renderHeight, target);
+				if (gRunBenchmarks && !mBenchmarksDone)
+				{
+					RunBenchmarks(scene, renderWidth, renderHeight, target);
+					mBenchmarksDone = true;
+				}
+			});
+		sceneColor = sceneTarget;
+
+		// 解析多采样目标；融合解析时色调映射直接读取多采样目标，这个通道没有读者而被剔除
+		if (mSceneDesc.samples > 0)
+		{
+			RenderTargetDesc resolvedDesc = mSceneDesc;
+			resolvedDesc.samples = 0;
+			resolvedDesc.depthFormat = GL_NONE;
+			const RenderGraph::Handle resolved = mRenderGraph.CreateTarget("Resolved", resolvedDesc);
+			mRenderGraph.AddPass("Resolve", [&](RenderGraph::PassBuilder& pass) { pass.Read(sceneTarget); pass.Write(resolved); },
+				[this, renderWidth, renderHeight, sceneTarget, resolved]() {
+					Buffer::ResolveFramebuffer(mRenderGraph.Get(sceneTarget).fb, mRenderGraph.Get(resolved).fb, renderWidth, renderHeight);
+				});
+			if (!gFusedResolve)
+			{
+				sceneColor = resolved;
+			}
+		}
+	}
 
+	if (gAntiAliasing == AntiAliasing::TAA)
+	{
+		// 与上一帧的输出混合，结果写入另一张历史目标并作为色调映射的输入
+		const RenderGraph::Handle history = mRenderGraph.ImportTarget("History", mHistoryTargets[mFrameIndex % 2]);
+		const RenderGraph::Handle output = mRenderGraph.ImportTarget("HistoryOutput", mHistoryTargets[(mFrameIndex + 1) % 2]);
+		const float feedback = mFrameIndex == 0 ? 0.0f : gTAAFeedback;
+		mRenderGraph.AddPass("TAA", [&](RenderGraph::PassBuilder& pass) { pass.Read(sceneColor); pass.Read(history); pass.Write(output); },
+			[this, jitter, feedback, viewportScale, sceneColor, history, output]() {
+				glViewport(0, 0, gDisplaySizeX, gDisplaySizeY);
+				glDisable(GL_DEPTH_TEST);
+				glBindFramebuffer(GL_FRAMEBUFFER, mRenderGraph.Get(output).fb.id);
+				glUseProgram(mTaaProgram);
+				glProgramUniform2f(mTaaProgram, 0, jitter.x * 0.5f, jitter.y * 0.5f);
+				glProgramUniform1f(mTaaProgram, 1, feedback);
+				glProgramUniform2f(mTaaProgram, 2, viewportScale.x, viewportScale.y);
+				glBindTextureUnit(0, mRenderGraph.Get(sceneColor).fb.colorTarget);
+				glBindTextureUnit(1, mRenderGraph.Get(sceneColor).velocity);
+				glBindTextureUnit(2, mRenderGraph.Get(history).fb.colorTarget);
+				glBindVertexArray(mEmptyVAO);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			});
+		sceneColor = output;
+	}
 
-	// 绘制天空盒
-	glDisable(GL_DEPTH_TEST);
-	glUseProgram(mSkyboxProgram);
-	glBindTextureUnit(0, mEnvTexture.mId);
-	glBindVertexArray(mSkybox.vao);
-	glDrawElements(GL_TRIANGLES, mSkybox.numElements, GL_UNSIGNED_INT, 0);
+	// 绘制一个全屏三角形，用于后期处理/色调映射
+	// TAA 已经输出显示分辨率；否则只采样视口区域，由双线性过滤放大到显示分辨率
+	// 按需渲染时先写入呈现目标，空闲时可以不重新渲染而再次呈现
+	const glm::vec2 uvScale = gAntiAliasing == AntiAliasing::TAA ? glm::vec2(1.0f) : viewportScale;
+	const GLuint tonemapProgram = visibilityBuffer ? mVisibilityTonemapProgram : mTonemapProgram;
+	const RenderGraph::Handle present = mRenderGraph.ImportTarget("Present", mPresentTarget);
+	mRenderGraph.AddPass("Tonemap", [&](RenderGraph::PassBuilder& pass) { pass.Read(sceneColor); pass.Write(present); },
+		[this, uvScale, tonemapProgram, sceneColor, present]() {
+			glViewport(0, 0, gDisplaySizeX, gDisplaySizeY);
+			glDisable(GL_DEPTH_TEST);
+			glBindFramebuffer(GL_FRAMEBUFFER, mRenderGraph.Get(present).fb.id);
+			glProgramUniform2f(tonemapProgram, 0, uvScale.x, uvScale.y);
+			glUseProgram(tonemapProgram);
+			glBindTextureUnit(0, mRenderGraph.Get(sceneColor).fb.colorTarget);
+			glBindVertexArray(mEmptyVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		});
+
+	mRenderGraph.Execute();
+	++mFrameIndex;
+
+	if (mDumpRenderGraph.exchange(false))
+	{
+		std::ofstream file("render_graph.dot");
+		file << mRenderGraph.ExportDot();
+		LOG_INFO(file ? "Render graph written to render_graph.dot" : "Failed to write render_graph.dot");
+	}
+
+	mFrameTimer.End();
+	mRedrawRequested = false;
+	PresentLastFrame(window);
+	mFramePacer.EndFrame(inputTime);
+	// 替换恢复完成的纹理、按预算裁剪冷纹理，本帧释放的纹理在栅栏之后销毁
+	mResources.EndFrame();
+	if (mTextureMemoryReport.exchange(false))
+	{
+		mResources.LogMemoryReport();
+	}
+
+#ifdef _DEBUG
+	// 输出了日志（热重载、切换路径、目标池增长、对比测试等）或切换了着色器变体的帧有事件发生，不算稳态
+	const uint64_t heapAllocations = FrameArena::HeapAllocations() - heapAllocationsBefore;
+	const bool steady = mFrameIndex > static_cast<uint32_t>(gHeapCheckWarmupFrames) && Log::MessageCount() == logMessagesBefore && !variantChanged;
+	if (steady && heapAllocations > 0)
+	{
+		LOG_ASSERT(true, std::format("Steady-state frame {} made {} general heap allocations", mFrameIndex, heapAllocations));
+	}
+#endif
+}
+
+void Renderer::WaitForNextFrame()
+{
+	mFramePacer.WaitForFrameSlot();
+}
+
+bool Renderer::ReloadShaders()
+{
+	// PBR 变体被替换后需要重新取得当前光源数量对应的程序；阴影程序可能已改变，缓存的阴影图作废
+	if (gShaderHotReload && Shader::UpdateHotReload())
+	{
+		mPbrLightCount = -1;
+		InvalidateShadowCache();
+		return true;
+	}
+	return false;
+}
 
-	// 绘制 PBR 模型
+bool Renderer::NeedsRedraw()
+{
+	if (ReloadShaders())
+	{
+		mRedrawRequested = true;
+	}
+	return mRedrawRequested || mFrameIndex == 0 || mShadowUpdatesPending || mDumpRenderGraph
+		|| mTextureMemoryReport || mResources.HasPendingWork()
+		|| (gAntiAliasing == AntiAliasing::TAA && mStillFrames < gTAASettleFrames);
+}
+
+void Renderer::PresentLastFrame(GLFWwindow* window)
+{
+	if (mPresentTarget.fb.id)
+	{
+		glBlitNamedFramebuffer(mPresentTarget.fb.id, 0, 0, 0, gDisplaySizeX, gDisplaySizeY,
+			0, 0, gDisplaySizeX, gDisplaySizeY, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glfwSwapBuffers(window);
+}
+
+void Renderer::RequestRenderGraphDump()
+{
+	mDumpRenderGraph = true;
+}
+
+void Renderer::RequestTextureMemoryReport()
+{
+	mTextureMemoryReport = true;
+}
+
+void Renderer::SetRenderPath(RenderPath path)
+{
+	if (path == mRenderPath) return;
+	mRenderPath = path;
+	// 下一帧重新取得当前光源数量对应的程序
+	mPbrLightCount = -1;
+	mRedrawRequested = true;
+	LOG_INFO(path == RenderPath::VisibilityBuffer ? "Render path: visibility buffer" : "Render path: forward");
+}
+
+void Renderer::RenderForward(int renderWidth, int renderHeight, const RenderTarget& target)
+{
+	// 准备用于渲染的帧缓冲
+	glBindFramebuffer(GL_FRAMEBUFFER, target.fb.id);
+	glViewport(0, 0, renderWidth, renderHeight);
+	// 无需清除颜色，因为天空盒会覆盖所有未被模型遮挡的像素。
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// 深度预通道：只写深度，之后的 PBR 通道只对最终可见的片元着色
 	glEnable(GL_DEPTH_TEST);
-	glUseProgram(mPbrProgram);
+	const bool depthPrepass = UpdateDepthPrepass();
+	if (depthPrepass)
+	{
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		mDrawQueue.Submit(DrawPass::DepthPrepass);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	// 绘制 PBR 模型，模型矩阵来自绘制队列的记录，队列按批次切换程序与材质
+	BindMaterialTextures();
+	// 空闲时测量本帧 PBR 通道通过深度测试的样本数，用于 Auto 模式的过度绘制估计
+	const bool measureOverdraw = mOverdrawQuery && !mOverdrawQueryPending;
+	if (measureOverdraw)
+	{
+		glBeginQuery(GL_SAMPLES_PASSED, mOverdrawQuery);
+	}
+	mDrawQueue.Submit(DrawPass::Opaque);
+	if (measureOverdraw)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+		mOverdrawQueryPending = true;
+		mOverdrawQueryPrepass = depthPrepass;
+		mOverdrawQueryPixels = double(renderWidth) * renderHeight;
+	}
+	if (depthPrepass)
+	{
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+	}
+
+	// 绘制天空盒，只填充模型没有覆盖的像素
+	DrawSkybox();
+}
+
+void Renderer::RasterizeVisibility(int renderWidth, int renderHeight, const RenderTarget& visibility)
+{
+	// 只写入实例与三角形编号和深度，没有几何的像素保持 0
+	const GLuint noGeometry = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, visibility.fb.id);
+	glViewport(0, 0, renderWidth, renderHeight);
+	glClearNamedFramebufferuiv(visibility.fb.id, GL_COLOR, 0, &noGeometry);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glProgramUniform1ui(mVisibilityProgram, 1, mDrawQueue.FirstRecord(DrawPass::Visibility));
+	mDrawQueue.Submit(DrawPass::Visibility);
+}
+
+void Renderer::ShadeVisibility(int renderWidth, int renderHeight, const RenderTarget& visibility, const RenderTarget& color)
+{
+	// 每个像素一个线程，模型矩阵与网格位置来自实例编号对应的绘制记录，三角形从网格缓冲区池读取
+	// （顶点 SSBO 与记录缓冲区已由可见性通道的提交绑定）
+	glProgramUniform1ui(mVisibilityShadeProgram, 1, mDrawQueue.FirstRecord(DrawPass::Visibility));
+	glProgramUniform2i(mVisibilityShadeProgram, 3, renderWidth, renderHeight);
+	glProgramUniform1i(mVisibilityShadeProgram, 4, color.velocity ? 1 : 0);
+	glProgramUniformMatrix4fv(mVisibilityShadeProgram, 5, 1, GL_FALSE, glm::value_ptr(mInverseSkyProjection));
+	glUseProgram(mVisibilityShadeProgram);
+	BindMaterialTextures();
+	glBindImageTexture(0, visibility.fb.colorTarget, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+	glBindImageTexture(1, color.fb.colorTarget, 0, GL_FALSE, 0, GL_WRITE_ONLY, color.desc.colorFormat);
+	if (color.velocity)
+	{
+		glBindImageTexture(2, color.velocity, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mMeshArena.indexBuffer);
+	glDispatchCompute((renderWidth + 7) / 8, (renderHeight + 7) / 8, 1);
+	// TAA 与色调映射采样结果
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void Renderer::BindMaterialTextures()
+{
 	/***********************satert 1*********************/
-	glBindTextureUnit(0, mAlbedoTexture.mId);
-	glBindTextureUnit(1, mNormalTexture.mId);
-	glBindTextureUnit(2, mMetalnessTexture.mId);
-	glBindTextureUnit(3, mRoughnessTexture.mId);
+	glBindTextureUnit(0, mResources.Get(mAlbedoTexture));
+	glBindTextureUnit(1, mResources.Get(mNormalTexture));
+	glBindTextureUnit(2, mResources.Get(mMetalnessTexture));
+	glBindTextureUnit(3, mResources.Get(mRoughnessTexture));
 	/***********************end 1**************************/
 	glBindTextureUnit(4, mEnvTexture.mId);
 	glBindTextureUnit(5, mIrmapTexture.mId);
 	glBindTextureUnit(6, mSpBRDF_LUT.mId);
-	glBindVertexArray(mPbrModel.vao);
-	glDrawElements(GL_TRIANGLES, mPbrModel.numElements, GL_UNSIGNED_INT, 0);
-		
-	// 解析多采样帧缓冲区
-	Buffer::ResolveFramebuffer(mFreameBuffer, mResolveFramebuffer);
+	glBindTextureUnit(7, mShadowTexture);
+}
 
-	// 绘制一个全屏三角形，用于后期处理/色调映射
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glUseProgram(mTonemapProgram);
-	glBindTextureUnit(0, mResolveFramebuffer.colorTarget);
-	glBindVertexArray(mEmptyVAO);
-	glDrawArrays(GL_TRIANGLES, 0, 3);
+void Renderer::UpdateDynamicResolution()
+{
+	// 计时结果滞后几帧；改变分辨率后等待查询环中的旧结果读完再做下一次调整，避免振荡
+	const int settleFrames = 8;
+	float gpuMs;
+	if (!mFrameTimer.Poll(gpuMs))
+	{
+		return;
+	}
+	mGpuFrameMs = mGpuFrameMs > 0.0f ? glm::mix(mGpuFrameMs, gpuMs, 0.2f) : gpuMs;
+	if (++mFramesSinceResize < settleFrames)
+	{
+		return;
+	}
 
-	glfwSwapBuffers(window);
+	// GPU 时间近似与像素数量成正比，边长按时间比的平方根调整；留出 10% 余量，单次最多调整 10%
+	const float headroom = 0.9f;
+	float scale = mRenderScale * glm::sqrt(gTargetFrameMs * headroom / mGpuFrameMs);
+	scale = glm::clamp(scale, mRenderScale * 0.9f, mRenderScale * 1.1f);
+	scale = glm::clamp(scale, gMinRenderScale, gMaxRenderScale);
+	if (glm::abs(scale - mRenderScale) >= 0.02f)
+	{
+		mRenderScale = scale;
+		mFramesSinceResize = 0;
+	}
 }
 
 
 
-Texture Renderer::LoadAndConvertEquirectangularToCubemap() {
+bool Renderer::UpdateDepthPrepass()
+{
+	if (gDepthPrepass != DepthPrepass::Auto)
+	{
+		return gDepthPrepass == DepthPrepass::On;
+	}
+
+	// 取回之前帧的样本数（不等待），按像素数归一化，避免动态分辨率影响比较
+	if (mOverdrawQueryPending)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(mOverdrawQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint64 samples = 0;
+			glGetQueryObjectui64v(mOverdrawQuery, GL_QUERY_RESULT, &samples);
+			mOverdrawQueryPending = false;
+			mShadedSamples[mOverdrawQueryPrepass] = glm::max(samples / mOverdrawQueryPixels, 1e-6);
+			mShadedSamplesFrame[mOverdrawQueryPrepass] = mFrameIndex;
+
+			// 没有预通道时通过深度测试的样本包括之后被覆盖的片元，有预通道时只有可见样本
+			if (mShadedSamples[0] > 0.0 && mShadedSamples[1] > 0.0)
+			{
+				const double overdraw = mShadedSamples[0] / mShadedSamples[1];
+				const bool enable = overdraw > gPrepassOverdrawThreshold;
+				if (enable != mDepthPrepass)
+				{
+					LOG_INFO(std::format("Depth prepass {}: measured overdraw {:.2f} (threshold {:.2f})",
+						enable ? "enabled" : "disabled", overdraw, gPrepassOverdrawThreshold));
+					mDepthPrepass = enable;
+				}
+			}
+		}
+	}
+
+	// 另一种方式的测量缺失或过期时，本帧以另一种方式渲染并测量；两种方式的画面相同
+	const bool other = !mDepthPrepass;
+	if (!mOverdrawQueryPending && (mShadedSamples[other] == 0.0 || mFrameIndex - mShadedSamplesFrame[other] >= uint32_t(gPrepassProbeFrames)))
+	{
+		return other;
+	}
+	return mDepthPrepass;
+}
+
+std::vector<SceneSettings::LocalLight> Renderer::CreateLightField(int count, float radius, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	std::vector<SceneSettings::LocalLight> lights(count);
+	for (SceneSettings::LocalLight& light : lights)
+	{
+		// 球内均匀分布：方向均匀，半径按体积取立方根
+		const float z = uniform(random) * 2.0f - 1.0f;
+		const float phi = uniform(random) * glm::two_pi<float>();
+		const float r = radius * std::cbrt(uniform(random));
+		light.position = r * glm::vec3(std::sqrt(1.0f - z * z) * std::cos(phi), std::sqrt(1.0f - z * z) * std::sin(phi), z);
+		light.range = gLocalLightRange;
+		light.radiance = gLocalLightIntensity * glm::rgbColor(glm::vec3(uniform(random) * 360.0f, 0.7f, 1.0f));
+		if (uniform(random) < 0.25f && r > 0.0f)
+		{
+			light.direction = -light.position / r;
+			light.cosInner = std::cos(glm::radians(20.0f));
+			light.cosOuter = std::cos(glm::radians(35.0f));
+		}
+	}
+	return lights;
+}
+
+void Renderer::UploadLocalLights(const std::vector<SceneSettings::LocalLight>& lights)
+{
+	mLocalLightCount = glm::min(int(lights.size()), gMaxLocalLights);
+	if (mLocalLightCount == 0)
+	{
+		return;
+	}
+
+	// 每帧上传，暂存在帧分配器中
+	FrameVector<LocalLightSB> packed(mLocalLightCount);
+	for (int i = 0; i < mLocalLightCount; ++i)
+	{
+		const SceneSettings::LocalLight& light = lights[i];
+		packed[i].positionRange = glm::vec4(light.position, light.range);
+		packed[i].radianceCosInner = glm::vec4(light.radiance, light.cosInner);
+		packed[i].directionCosOuter = glm::vec4(light.direction, light.cosOuter);
+	}
+	glNamedBufferSubData(mLocalLightSB, 0, packed.size() * sizeof(LocalLightSB), packed.data());
+}
+
+void Renderer::BuildLightClusters()
+{
+	// 深度按指数分层：slice = log(depth / near) * Z / log(far / near)
+	const float sliceScale = gClusterGridZ / std::log(kFarPlane / kNearPlane);
+	ClusterUB clusterUniforms;
+	clusterUniforms.viewMatrix = mViewMatrix;
+	clusterUniforms.projectionMatrix = mProjectionMatrix;
+	clusterUniforms.inverseProjectionMatrix = glm::inverse(mProjectionMatrix);
+	clusterUniforms.grid = glm::uvec4(gClusterGridX, gClusterGridY, gClusterGridZ, mLocalLightCount);
+	clusterUniforms.depth = glm::vec4(kNearPlane, kFarPlane, sliceScale, -std::log(kNearPlane) * sliceScale);
+	glNamedBufferSubData(mClusterUB, 0, sizeof(ClusterUB), &clusterUniforms);
+
+	// 这些绑定点之后由 PBR 通道沿用，其他通道不会占用
+	glUseProgram(mClusterProgram);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 2, mClusterUB);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mLocalLightSB);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mClusterLightCounts);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mClusterLightIndices);
+	glDispatchCompute((kNumClusters + 127) / 128, 1, 1);		// cluster.comp 的工作组大小为 128
+	// PBR 片元着色器读取簇的光源列表
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void Renderer::UpdateShadowMaps(const SceneSettings& scene, const glm::mat4& sceneRotationMatrix)
+{
+	ShadowUB shadowUniforms{};
+	if (!gShadows)
+	{
+		glNamedBufferSubData(mShadowUB, 0, sizeof(ShadowUB), &shadowUniforms);
+		return;
+	}
+
+	// 每一级视锥切片的包围球：半径只取决于投影，旋转相机时不变；球心在视线上，随相机移动
+	const glm::mat4 inverseView = glm::inverse(mViewMatrix);
+	const float tanHalfX = 1.0f / mProjectionMatrix[0][0];
+	const float tanHalfY = 1.0f / mProjectionMatrix[1][1];
+	const float slopeSq = tanHalfX * tanHalfX + tanHalfY * tanHalfY;
+	glm::vec3 centers[mkMaxShadowCascades];
+	float radii[mkMaxShadowCascades];
+	float splitNear = kNearPlane;
+	for (int c = 0; c < gShadowCascades; ++c)
+	{
+		const float t = float(c + 1) / gShadowCascades;
+		const float logSplit = kNearPlane * std::pow(gShadowDistance / kNearPlane, t);
+		const float uniformSplit = kNearPlane + (gShadowDistance - kNearPlane) * t;
+		const float splitFar = gShadowSplitLambda * logSplit + (1.0f - gShadowSplitLambda) * uniformSplit;
+		// 到近端四角与远端四角距离相等的视线上的点，超出远端时取远端中心
+		const float centerDepth = glm::min((slopeSq + 1.0f) * (splitFar + splitNear) * 0.5f, splitFar);
+		radii[c] = std::sqrt(slopeSq * splitFar * splitFar + (splitFar - centerDepth) * (splitFar - centerDepth));
+		centers[c] = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+		shadowUniforms.cascadeSplits[c] = splitFar;
+		shadowUniforms.cascadeTexelSizes[c] = 2.0f * radii[c] / gShadowMapSize;
+		splitNear = splitFar;
+	}
+	shadowUniforms.params = glm::uvec4(gShadowCascades, 0, 0, 0);
+
+	// 本帧每一级应有的矩阵；与缓存渲染时的矩阵和场景旋转相同则不需要重新渲染。
+	// 缓存与阴影图的层按场景光源序号排列，开关其他光源时启用光源的紧凑序号改变，但缓存仍属于同一个光源
+	glm::mat4 matrices[SceneSettings::NumLights][mkMaxShadowCascades];
+	bool dirty[SceneSettings::NumLights][mkMaxShadowCascades] = {};
+	int sceneLights[SceneSettings::NumLights];	// 第 n 个启用光源的场景光源序号
+	int numLights = 0;
+	for (int i = 0; i < SceneSettings::NumLights; ++i)
+	{
+		const SceneSettings::Light& light = scene.lights[i];
+		if (!light.enabled) continue;
+		sceneLights[numLights] = i;
+		shadowUniforms.lightLayers[numLights] = i * gShadowCascades;
+		const glm::vec3 direction = glm::normalize(light.direction);
+		const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+		for (int c = 0; c < gShadowCascades; ++c)
+		{
+			// 球心在光源空间中对齐到纹素：相机的微小移动不改变矩阵，缓存保持有效，阴影边缘也不会闪烁
+			const float texel = shadowUniforms.cascadeTexelSizes[c];
+			const glm::vec3 center = glm::floor(glm::vec3(lightView * glm::vec4(centers[c], 1.0f)) / texel) * texel;
+			const float radius = radii[c];
+			matrices[i][c] = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius,
+				-(center.z + radius), -(center.z - radius)) * lightView;
+			const ShadowCascade& cascade = mShadowCascades[i][c];
+			dirty[i][c] = !cascade.valid || cascade.matrix != matrices[i][c] || cascade.sceneRotation != sceneRotationMatrix;
+		}
+		++numLights;
+	}
+
+	auto render = [&](int light, int c) {
+		ShadowCascade& cascade = mShadowCascades[light][c];
+		cascade.matrix = matrices[light][c];
+		cascade.sceneRotation = sceneRotationMatrix;
+		cascade.valid = true;
+		RenderShadowCascade(light * gShadowCascades + c, cascade.matrix * sceneRotationMatrix);
+	};
+
+	// 最近一级和从未渲染过的级联立即更新；其余变化的级联按轮转每帧更新一级
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_DEPTH_CLAMP);		// 级联之外朝向光源的遮挡物压到近平面上，仍然投射阴影
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 2.0f);
+	for (int n = 0; n < numLights; ++n)
+	{
+		const int light = sceneLights[n];
+		for (int c = 0; c < gShadowCascades; ++c)
+		{
+			if (dirty[light][c] && (c == 0 || !mShadowCascades[light][c].valid))
+			{
+				render(light, c);
+				dirty[light][c] = false;
+			}
+		}
+	}
+	const int numFarSlots = numLights * (gShadowCascades - 1);
+	int numPending = 0;
+	for (int i = 0; i < numFarSlots; ++i)
+	{
+		const int slot = (mShadowCursor + i) % numFarSlots;
+		const int light = sceneLights[slot / (gShadowCascades - 1)];
+		const int c = slot % (gShadowCascades - 1) + 1;
+		if (!dirty[light][c]) continue;
+		if (numPending++ == 0)
+		{
+			render(light, c);
+			mShadowCursor = slot + 1;
+		}
+	}
+	mShadowUpdatesPending = numPending > 1;
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+	mShadowCascadeSlots += uint64_t(numLights) * gShadowCascades;
+
+	// 着色使用各级实际渲染时的矩阵，等待轮转的级联与其缓存内容保持一致；纹理坐标与深度从 [-1,1] 映射到 [0,1]
+	const glm::mat4 textureBias = glm::translate(glm::mat4{ 1.0f }, glm::vec3(0.5f)) * glm::scale(glm::mat4{ 1.0f }, glm::vec3(0.5f));
+	for (int n = 0; n < numLights; ++n)
+	{
+		const int light = sceneLights[n];
+		for (int c = 0; c < gShadowCascades; ++c)
+		{
+			shadowUniforms.matrices[light * gShadowCascades + c] = textureBias * mShadowCascades[light][c].matrix;
+		}
+	}
+	glNamedBufferSubData(mShadowUB, 0, sizeof(ShadowUB), &shadowUniforms);
+}
+
+void Renderer::RenderShadowCascade(int layer, const glm::mat4& sceneToShadow)
+{
+	glNamedFramebufferTextureLayer(mShadowFramebuffer, GL_DEPTH_ATTACHMENT, mShadowTexture, 0, layer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mShadowFramebuffer);
+	glViewport(0, 0, gShadowMapSize, gShadowMapSize);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glProgramUniformMatrix4fv(mShadowProgram, 0, 1, GL_FALSE, glm::value_ptr(sceneToShadow));
+	mDrawQueue.Submit(DrawPass::Shadow);
+	++mShadowCascadeRenders;
+}
+
+void Renderer::InvalidateShadowCache()
+{
+	for (auto& cascades : mShadowCascades)
+	{
+		for (ShadowCascade& cascade : cascades)
+		{
+			cascade.valid = false;
+		}
+	}
+}
+
+void Renderer::LogRenderTargetBudget(int samples)
+{
+	// 估算两种抗锯齿模式的渲染目标显存与每帧带宽：不计过度绘制与帧缓冲压缩，
+	// 场景目标写一次，后处理读写各一次（TAA 的 3x3 邻域采样按缓存命中计为读一次）
+	struct Budget { double msaaMemory, msaaBandwidth, taaMemory, taaBandwidth; };
+	const double MB = 1024.0 * 1024.0;
+	const double velocityBytes = 4.0, depthBytes = 4.0;
+	const int msaaSamples = glm::max(samples, 1);
+	const bool fused = gFusedResolve && samples > 0;
+
+	auto estimate = [&](int displayX, int displayY, double colorBytes)
+	{
+		const double displayPixels = double(displayX) * displayY;
+		Budget budget;
+		// MSAA：多采样颜色 + 深度模板，解析到单样本目标后色调映射；
+		// 融合解析时色调映射直接读取全部样本，没有解析目标及其写入和读取
+		budget.msaaMemory = displayPixels * msaaSamples * (colorBytes + depthBytes) + (samples > 0 && !fused ? displayPixels * colorBytes : 0.0);
+		budget.msaaBandwidth = displayPixels * msaaSamples * (colorBytes + depthBytes)	// 场景写入
+			+ (samples > 0 ? displayPixels * msaaSamples * colorBytes : 0.0)				// 解析（或融合解析）读取全部样本
+			+ (samples > 0 && !fused ? displayPixels * colorBytes : 0.0)					// 解析写入
+			+ (fused ? 0.0 : displayPixels * colorBytes);									// 色调映射读取
+
+		// TAA：内部分辨率的颜色 + 运动向量 + 深度模板，两张显示分辨率的历史目标
+		const double internalPixels = double(int(displayX * gRenderScale)) * int(displayY * gRenderScale);
+		budget.taaMemory = internalPixels * (colorBytes + velocityBytes + depthBytes) + 2.0 * displayPixels * colorBytes;
+		budget.taaBandwidth = internalPixels * (colorBytes + velocityBytes + depthBytes)	// 场景写入
+			+ internalPixels * (colorBytes + velocityBytes)									// TAA 读取当前帧
+			+ displayPixels * 2.0 * colorBytes												// TAA 读历史、写输出
+			+ displayPixels * colorBytes;													// 色调映射读取
+		return budget;
+	};
+
+	// 当前分辨率下输出两种模式的预算；另外按 1080p 与 4K 输出所选颜色格式相对 RGBA16F 参考节省的显存和带宽
+	const GLenum colorFormat = SceneColorFormat(gColorQuality);
+	const char* formatName = colorFormat == GL_RGBA16F ? "RGBA16F" : "R11G11B10F";
+	const Budget current = estimate(gDisplaySizeX, gDisplaySizeY, ColorFormatBytes(colorFormat));
+	LOG_INFO(std::format("Render targets [MSAA {}x{}, {}]: {:.1f} MB, ~{:.1f} MB/frame{}",
+		msaaSamples, fused ? ", fused resolve" : "", formatName, current.msaaMemory / MB, current.msaaBandwidth / MB, gAntiAliasing == AntiAliasing::MSAA ? " (active)" : ""));
+	LOG_INFO(std::format("Render targets [TAA {:.0f}% scale, {}]: {:.1f} MB, ~{:.1f} MB/frame{}",
+		gRenderScale * 100.0f, formatName, current.taaMemory / MB, current.taaBandwidth / MB, gAntiAliasing == AntiAliasing::TAA ? " (active)" : ""));
+
+	for (const glm::ivec2 resolution : { glm::ivec2(1920, 1080), glm::ivec2(3840, 2160) })
+	{
+		const Budget lean = estimate(resolution.x, resolution.y, ColorFormatBytes(colorFormat));
+		const Budget reference = estimate(resolution.x, resolution.y, ColorFormatBytes(GL_RGBA16F));
+		const bool msaa = gAntiAliasing == AntiAliasing::MSAA;
+		const double memory = msaa ? lean.msaaMemory : lean.taaMemory;
+		const double bandwidth = msaa ? lean.msaaBandwidth : lean.taaBandwidth;
+		const double referenceMemory = msaa ? reference.msaaMemory : reference.taaMemory;
+		const double referenceBandwidth = msaa ? reference.msaaBandwidth : reference.taaBandwidth;
+		LOG_INFO(std::format("Scene color {} at {}p: {:.1f} MB (saves {:.1f} MB), ~{:.1f} MB/frame (saves {:.1f} MB/frame) vs RGBA16F",
+			formatName, resolution.y, memory / MB, (referenceMemory - memory) / MB, bandwidth / MB, (referenceBandwidth - bandwidth) / MB));
+	}
+}
+
+void Renderer::DrawSkybox()
+{
+	// 天空盒的深度固定在远平面，以 GL_LEQUAL 通过清除后的深度（1.0），被遮挡的像素由提前深度测试剔除；
+	// 天空盒不写入深度。之后恢复默认的深度状态
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	glUseProgram(mSkyboxProgram);
+	glBindTextureUnit(0, mEnvTexture.mId);
+	glBindVertexArray(mSkybox.vao);
+	glDrawElements(GL_TRIANGLES, mSkybox.numElements, GL_UNSIGNED_INT, 0);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
+
+void Renderer::QueueSceneDraws(const glm::mat4& sceneRotationMatrix, const glm::vec3& eyePosition)
+{
+	// 所有网格共用缓冲区池的 VAO，basevertex 会加到 gl_VertexID 上
+	DrawGeometry pulled;
+	pulled.vao = mMeshArena.vao;
+	pulled.vertexStorage = mMeshArena.vertexBuffer;
+	pulled.numElements = mPbrModelPulled.numElements;
+	pulled.firstIndex = mPbrModelPulled.firstIndex;
+	pulled.baseVertex = mPbrModelPulled.baseVertex;
+	DrawGeometry shaded = pulled;
+	if (!gVertexPulling)
+	{
+		shaded = DrawGeometry();
+		shaded.vao = mPbrModel.vao;
+		shaded.numElements = mPbrModel.numElements;
+	}
+	DrawGeometry depthOnly;
+	depthOnly.vao = mPbrDepthModel.vao;
+	depthOnly.numElements = mPbrDepthModel.numElements;
+	depthOnly.firstIndex = mPbrDepthModel.firstIndex;
+
+	// 模型在 XZ 平面上排成网格，每个模型缩小为原来的 0.2；
+	// 前向与可见性缓冲区两条路径的绘制都加入队列，切换路径与对比测试不需要重建
+	// 材质纹理可能被裁剪或恢复为新的纹理对象，每帧重新取得并记录使用
+	mPbrMaterial.textures[0] = mResources.Use(mAlbedoTexture);
+	mPbrMaterial.textures[1] = mResources.Use(mNormalTexture);
+	mPbrMaterial.textures[2] = mResources.Use(mMetalnessTexture);
+	mPbrMaterial.textures[3] = mResources.Use(mRoughnessTexture);
+
+	mDrawQueue.Clear();
+	const float gridOffset = (gModelGrid - 1) * 0.5f;
+	for (int z = 0; z < gModelGrid; ++z)
+	{
+		for (int x = 0; x < gModelGrid; ++x)
+		{
+			const glm::vec3 position = glm::vec3(x - gridOffset, 0.0f, z - gridOffset) * gModelSpacing;
+			const glm::mat4 model = glm::scale(glm::translate(glm::mat4{ 1.0f }, position), glm::vec3(0.2f));
+			const float depth = glm::distance(eyePosition, glm::vec3(sceneRotationMatrix * glm::vec4(position, 1.0f))) / kFarPlane;
+			if (mShadowProgram)
+			{
+				mDrawQueue.Add(DrawPass::Shadow, mShadowProgram, nullptr, pulled, model, 0.0f);
+			}
+			if (mDepthProgram)
+			{
+				mDrawQueue.Add(DrawPass::DepthPrepass, mDepthProgram, nullptr, depthOnly, model, depth);
+			}
+			mDrawQueue.Add(DrawPass::Opaque, mPbrProgram, &mPbrMaterial, shaded, model, depth);
+			mDrawQueue.Add(DrawPass::Visibility, mVisibilityProgram, nullptr, pulled, model, depth);
+		}
+	}
+	mDrawQueue.Build();
+}
+
+void Renderer::DrawPbrModel(bool vertexPulling)
+{
+	// 使用不透明通道第一个绘制的记录（模型矩阵）
+	const GLuint record = mDrawQueue.FirstRecord(DrawPass::Opaque);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, mDrawQueue.RecordBuffer());
+	if (vertexPulling)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mMeshArena.vertexBuffer);
+		glBindVertexArray(mMeshArena.vao);
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mPbrModelPulled.numElements, GL_UNSIGNED_INT,
+			reinterpret_cast<const void*>(mPbrModelPulled.firstIndex * sizeof(uint32_t)), 1, mPbrModelPulled.baseVertex, record);
+	}
+	else
+	{
+		glBindVertexArray(mPbrModel.vao);
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, mPbrModel.numElements, GL_UNSIGNED_INT, 0, 1, record);
+	}
+}
+
+void Renderer::RunBenchmarks(const SceneSettings& scene, int renderWidth, int renderHeight, const RenderTarget& target)
+{
+	// 在第一帧的渲染状态下（统一缓冲区、纹理、帧缓冲已就绪）重复绘制 PBR 模型，比较两种顶点输入方式的 GPU 时间
+	const int numDraws = 100;
+	GLuint query;
+	glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+
+	for (bool vertexPulling : { false, true })
+	{
+		const GLuint program = Shader::GetProgramVariant({ "pbr.vert","pbr.frag" }, PbrVariant(mPbrLightCount, vertexPulling));
+		glUseProgram(program);
+
+		// 预热一次，排除首次绘制时驱动的延迟工作
+		DrawPbrModel(vertexPulling);
+		glFinish();
+
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		for (int i = 0; i < numDraws; ++i)
+		{
+			DrawPbrModel(vertexPulling);
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+		const size_t vertexBytes = mMeshArena.numVertices * (vertexPulling ? Buffer::mkPackedVertexSize : sizeof(Mesh::Vertex));
+		LOG_INFO(std::format("Vertex input benchmark [{}]: {:.3f} ms per draw, vertex data {:.1f} KB",
+			vertexPulling ? "SSBO pulling" : "VAO", elapsedNs / 1.0e6 / numDraws, vertexBytes / 1024.0));
+	}
+
+	glDeleteQueries(1, &query);
+	BenchmarkCommandLists();
+	glUseProgram(mPbrProgram);
+
+	BenchmarkSkyboxOrder();
+	BenchmarkClusteredLights(scene);
+	BenchmarkRenderPaths(renderWidth, renderHeight, target);
+	TestColorPrecision();
+}
+
+void Renderer::BenchmarkCommandLists()
+{
+	// 每个物体一次 uniform 写入加一次绘制（模型的前 64 个三角形，可见性缓冲区程序），
+	// 物体平均分成 1~16 个命令列表，由任务系统并行录制，比较录制的墙钟时间与 GL 线程回放的 CPU 时间
+	const int numObjects = 16384;
+	const GLuint trianglesPerDraw = 64;
+	const int size = 256;
+	const GLuint firstRecord = mDrawQueue.FirstRecord(DrawPass::Visibility);
+	const GLuint numRecords = glm::max(mDrawQueue.NumRecords(DrawPass::Visibility), 1u);
+	const GLuint numTriangles = mPbrModelPulled.numElements / 3;
+
+	GLint previousFramebuffer = 0;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	FrameBuffer framebuffer = Buffer::CreateFrameBuffer(size, size, 0, GL_R32UI, GL_DEPTH24_STENCIL8);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.id);
+	glViewport(0, 0, size, size);
+
+	auto record = [&](CommandList& list, size_t begin, size_t end) {
+		list.UseProgram(mVisibilityProgram);
+		list.BindVertexArray(mMeshArena.vao);
+		list.BindStorageBuffer(0, mMeshArena.vertexBuffer);
+		list.BindStorageBuffer(5, mDrawQueue.RecordBuffer());
+		for (size_t i = begin; i < end; ++i)
+		{
+			const GLuint triangle = static_cast<GLuint>(i * trianglesPerDraw % glm::max(numTriangles - trianglesPerDraw, 1u));
+			const GLuint record = firstRecord + static_cast<GLuint>(i % numRecords);
+			// 每个物体写入不同的值：着色器中的实例编号为记录序号与该值之差（无符号回绕），即物体序号的低 8 位
+			list.Uniform1ui(mVisibilityProgram, 1, record - static_cast<GLuint>(i % 256));
+			list.DrawElements(trianglesPerDraw * 3, mPbrModelPulled.firstIndex + triangle * 3, 1, mPbrModelPulled.baseVertex, record);
+		}
+	};
+
+	double baselineMs = 0.0;
+	for (int numLists = 1; numLists <= 16; numLists *= 2)
+	{
+		std::vector<CommandList> lists(numLists);
+		// 第一次录制使列表分配到所需容量，之后的录制与每帧的情况相同
+		CommandList::RecordParallel(lists, numObjects, record);
+		const int numRuns = 10;
+		const auto recordStart = std::chrono::steady_clock::now();
+		for (int run = 0; run < numRuns; ++run)
+		{
+			CommandList::RecordParallel(lists, numObjects, record);
+		}
+		const double recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count() / numRuns;
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glFinish();
+		const auto replayStart = std::chrono::steady_clock::now();
+		size_t bytes = 0, commands = 0;
+		for (const CommandList& list : lists)
+		{
+			list.Replay();
+			bytes += list.Bytes();
+			commands += list.NumCommands();
+		}
+		const double replayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - replayStart).count();
+		glFinish();
+
+		if (numLists == 1) baselineMs = recordMs;
+		LOG_INFO(std::format("Command list benchmark [{} lists, {} workers]: record {:.3f} ms ({:.2f}x), replay {:.3f} ms, {} commands in {:.1f} KB",
+			numLists, JobSystem::NumWorkers(), recordMs, recordMs > 0.0 ? baselineMs / recordMs : 0.0, replayMs, commands, bytes / 1024.0));
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	Buffer::DeleteFrameBuffer(framebuffer);
+}
+
+void Renderer::BenchmarkRenderPaths(int renderWidth, int renderHeight, const RenderTarget& target)
+{
+	// 两条路径渲染同一帧的完整场景（不含后处理）；前向渲染最后执行，恢复本帧场景目标的内容
+	const int numFrames = 20;
+	GLuint query;
+	glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+	mVisibilityShadeProgram = Shader::GetProgramVariant({ "visibility.comp" }, VisibilityShadeVariant(mPbrLightCount));
+
+	// 可见性缓冲区路径的目标在帧图之外临时分配，与帧图中的描述相同
+	RenderTarget visibility;
+	visibility.desc = target.desc;
+	visibility.desc.samples = 0;
+	visibility.desc.colorFormat = GL_R32UI;
+	visibility.desc.velocity = false;
+	visibility.fb = Buffer::CreateFrameBuffer(target.desc.width, target.desc.height, 0, GL_R32UI, target.desc.depthFormat);
+	RenderTarget color;
+	color.desc = target.desc;
+	color.desc.samples = 0;
+	color.desc.depthFormat = GL_NONE;
+	color.fb = Buffer::CreateFrameBuffer(target.desc.width, target.desc.height, 0, target.desc.colorFormat, GL_NONE);
+	if (target.velocity)
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &color.velocity);
+		glTextureStorage2D(color.velocity, 1, GL_RG16F, target.desc.width, target.desc.height);
+	}
+
+	for (RenderPath path : { RenderPath::VisibilityBuffer, RenderPath::Forward })
+	{
+		const bool visibilityBuffer = path == RenderPath::VisibilityBuffer;
+		auto render = [&]() {
+			if (visibilityBuffer)
+			{
+				RasterizeVisibility(renderWidth, renderHeight, visibility);
+				ShadeVisibility(renderWidth, renderHeight, visibility, color);
+			}
+			else
+			{
+				RenderForward(renderWidth, renderHeight, target);
+			}
+		};
+
+		// 预热一次，排除首次使用时的资源创建和驱动延迟工作
+		render();
+		glFinish();
+
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		for (int i = 0; i < numFrames; ++i)
+		{
+			render();
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+		LOG_INFO(std::format("Render path benchmark [{}]: {:.3f} ms per frame at {}x{} ({} samples)",
+			visibilityBuffer ? "visibility buffer" : "forward", elapsedNs / 1.0e6 / numFrames,
+			renderWidth, renderHeight, visibilityBuffer ? 1 : glm::max(target.desc.samples, 1)));
+	}
+
+	glDeleteQueries(1, &query);
+	Buffer::DeleteFrameBuffer(visibility.fb);
+	Buffer::DeleteFrameBuffer(color.fb);
+	if (color.velocity) glDeleteTextures(1, &color.velocity);
+}
+
+void Renderer::BenchmarkClusteredLights(const SceneSettings& scene)
+{
+	GLuint queries[2];
+	glCreateQueries(GL_TIME_ELAPSED, 2, queries);
+	std::vector<GLuint> clusterCounts(kNumClusters);
+
+	for (bool constantDensity : { false, true })
+	{
+		for (int numLights = 1; numLights <= gMaxLocalLights; numLights *= 4)
+		{
+			// 密度不变时，64 个光源对应 gLightFieldRadius 的球
+			const float radius = constantDensity ? gLightFieldRadius * std::cbrt(numLights / 64.0f) : gLightFieldRadius;
+			UploadLocalLights(CreateLightField(numLights, radius, 1));
+			glFinish();
+
+			glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+			BuildLightClusters();
+			glEndQuery(GL_TIME_ELAPSED);
+
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glBeginQuery(GL_TIME_ELAPSED, queries[1]);
+			mDrawQueue.Submit(DrawPass::Opaque);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 clusterNs = 0, shadingNs = 0;
+			glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &clusterNs);
+			glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &shadingNs);
+
+			// 非空簇的平均光源数与最大光源数，达到上限的簇会丢失光源
+			glGetNamedBufferSubData(mClusterLightCounts, 0, clusterCounts.size() * sizeof(GLuint), clusterCounts.data());
+			size_t occupied = 0, total = 0, saturated = 0;
+			GLuint maxCount = 0;
+			for (GLuint count : clusterCounts)
+			{
+				occupied += count > 0 ? 1 : 0;
+				saturated += count >= GLuint(gClusterMaxLights) ? 1 : 0;
+				total += count;
+				maxCount = glm::max(maxCount, count);
+			}
+			LOG_INFO(std::format("Clustered lights benchmark [{}, {} lights, radius {:.0f}]: clusters {:.3f} ms, PBR pass {:.3f} ms, "
+				"{:.1f} lights per occupied cluster (max {}, {} saturated)",
+				constantDensity ? "constant density" : "fixed volume", numLights, radius, clusterNs / 1.0e6, shadingNs / 1.0e6,
+				occupied > 0 ? double(total) / occupied : 0.0, maxCount, saturated));
+		}
+	}
+	glDeleteQueries(2, queries);
+
+	// 恢复场景的光源并重新绘制本帧
+	UploadLocalLights(scene.localLights);
+	BuildLightClusters();
+	glClear(GL_DEPTH_BUFFER_BIT);
+	mDrawQueue.Submit(DrawPass::Opaque);
+	DrawSkybox();
+}
+
+void Renderer::BenchmarkSkyboxOrder()
+{
+	// 分别以旧顺序（先关闭深度测试绘制全屏天空盒，再绘制模型）和新顺序（先模型，再以 LEQUAL 绘制天空盒）
+	// 渲染一帧，用管线统计查询比较片元着色器调用次数。最后运行新顺序，帧缓冲内容与正常渲染一致
+	const bool statistics = GLAD_GL_ARB_pipeline_statistics_query != 0;
+	if (!statistics)
+	{
+		LOG_WARN("GL_ARB_pipeline_statistics_query is not supported, skybox benchmark reports GPU time only");
+	}
+
+	GLuint queries[2] = { 0, 0 };
+	glCreateQueries(GL_TIME_ELAPSED, 1, &queries[0]);
+	if (statistics)
+	{
+		glCreateQueries(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, 1, &queries[1]);
+	}
+
+	GLuint64 invocations[2] = { 0, 0 };
+	GLuint64 elapsedNs[2] = { 0, 0 };
+	for (bool skyboxLast : { false, true })
+	{
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glFinish();
+		glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+		if (statistics)
+		{
+			glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, queries[1]);
+		}
+
+		if (!skyboxLast)
+		{
+			glDisable(GL_DEPTH_TEST);
+			glUseProgram(mSkyboxProgram);
+			glBindTextureUnit(0, mEnvTexture.mId);
+			glBindVertexArray(mSkybox.vao);
+			glDrawElements(GL_TRIANGLES, mSkybox.numElements, GL_UNSIGNED_INT, 0);
+			glEnable(GL_DEPTH_TEST);
+		}
+		mDrawQueue.Submit(DrawPass::Opaque);
+		if (skyboxLast)
+		{
+			DrawSkybox();
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &elapsedNs[skyboxLast]);
+		if (statistics)
+		{
+			glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+			glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &invocations[skyboxLast]);
+		}
+	}
+	glDeleteQueries(statistics ? 2 : 1, queries);
+
+	LOG_INFO(std::format("Skybox order benchmark [first, no depth test]: {} fragment shader invocations, {:.3f} ms",
+		invocations[0], elapsedNs[0] / 1.0e6));
+	LOG_INFO(std::format("Skybox order benchmark [last, LEQUAL at far plane]: {} fragment shader invocations, {:.3f} ms (saves {:.1f}% invocations)",
+		invocations[1], elapsedNs[1] / 1.0e6, invocations[0] > 0 ? 100.0 * (1.0 - double(invocations[1]) / invocations[0]) : 0.0));
+}
+
+void Renderer::TestColorPrecision()
+{
+	// 覆盖暗部、显示范围和高光的对数渐变（[2^-10, 2^4]）：第一行为灰阶，第二行为暖色。
+	// 先上传到 RGBA32F 源目标，再由 GPU 位块传输写入 RGBA16F 参考目标和 R11G11B10F 目标，与渲染时的格式转换一致
+	const int width = 4096, height = 2;
+	std::vector<glm::vec4> ramp(width * height);
+	for (int x = 0; x < width; ++x)
+	{
+		const float value = std::exp2(-10.0f + 14.0f * x / (width - 1));
+		ramp[x] = glm::vec4(value, value, value, 1.0f);
+		ramp[width + x] = glm::vec4(value, value * 0.6f, value * 0.25f, 1.0f);
+	}
+
+	FrameBuffer source = Buffer::CreateFrameBuffer(width, height, 0, GL_RGBA32F, GL_NONE);
+	glTextureSubImage2D(source.colorTarget, 0, 0, 0, width, height, GL_RGBA, GL_FLOAT, ramp.data());
+
+	auto convert = [&](GLenum format)
+	{
+		FrameBuffer target = Buffer::CreateFrameBuffer(width, height, 0, format, GL_NONE);
+		glBlitNamedFramebuffer(source.id, target.id, 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		std::vector<glm::vec4> pixels(width * height);
+		glGetTextureImage(target.colorTarget, 0, GL_RGBA, GL_FLOAT, GLsizei(pixels.size() * sizeof(glm::vec4)), pixels.data());
+		Buffer::DeleteFrameBuffer(target);
+		return pixels;
+	};
+	const std::vector<glm::vec4> reference = convert(GL_RGBA16F);
+	const std::vector<glm::vec4> lean = convert(GL_R11F_G11F_B10F);
+	Buffer::DeleteFrameBuffer(source);
+
+	// 线性空间的相对误差；色调映射并量化为 8 位后与参考不同的像素数，以及灰阶的色偏（通道间最大差值）
+	double maxError = 0.0, sumError = 0.0;
+	int bandedPixels = 0, maxStep = 0, maxGrayTint = 0;
+	for (int i = 0; i < width * height; ++i)
+	{
+		const glm::vec3 expected = glm::vec3(reference[i]);
+		const glm::vec3 actual = glm::vec3(lean[i]);
+		const double error = glm::compMax(glm::abs(actual - expected) / glm::max(expected, glm::vec3(1e-6f)));
+		maxError = glm::max(maxError, error);
+		sumError += error;
+
+		const glm::ivec3 expectedDisplay = TonemapToDisplay(expected);
+		const glm::ivec3 actualDisplay = TonemapToDisplay(actual);
+		const int step = glm::compMax(glm::abs(actualDisplay - expectedDisplay));
+		bandedPixels += step > 0 ? 1 : 0;
+		maxStep = glm::max(maxStep, step);
+		if (i < width)
+		{
+			maxGrayTint = glm::max(maxGrayTint, glm::compMax(actualDisplay) - glm::compMin(actualDisplay));
+		}
+	}
+	LOG_INFO(std::format("Color precision [R11G11B10F vs RGBA16F]: relative error max {:.3f}% mean {:.3f}%, "
+		"8-bit output differs in {} of {} pixels (max {} LSB), gray ramp tint max {} LSB",
+		maxError * 100.0, sumError / (width * height) * 100.0, bandedPixels, width * height, maxStep, maxGrayTint));
+}
+
+Texture Renderer::LoadAndConvertEquirectangularToCubemap(const Image& equirect) {
 
 	// 创建一个立方体贴图纹理，大小为 gEnvMapSize x gEnvMapSize，格式为 GL_RGBA16F。
 	Texture envTextureUnfiltered = Texture(GL_TEXTURE_CUBE_MAP, gEnvMapSize, gEnvMapSize, GL_RGBA16F);
 	// 链接并编译着色器程序，用于将等矩形贴图转换为立方体贴图。
-	GLuint equirectToCubeProgram = Shader::LinkProgram({ "equirect2cube.comp" });
-	Texture envTextureEquirect = Texture("environment.hdr", 3, GL_RGB, GL_RGB16F, 1);
+	GLuint equirectToCubeProgram = Shader::LinkProgram({ "equirect2cube.comp" }, PrecomputeVariant());
+	Texture envTextureEquirect = Texture(equirect, GL_RGB, GL_RGB16F, 1);
 	glUseProgram(equirectToCubeProgram);
 	glBindTextureUnit(0, envTextureEquirect.mId);
 	glBindImageTexture(				// 绑定未过滤的环境立方体贴图到图像单元0，用于写操作
@@ -255,7 +1652,7 @@ Texture Renderer::LoadAndConvertEquirectangularToCubemap() {
 	// 启动计算着色器进行等矩形到立方体贴图的转换。
 	// 计算着色器会被分配的工作组数为 (envTextureUnfiltered.mWidth / 32) x (envTextureUnfiltered.mHeight / 32) x 6。
 	// 这里每个工作组处理 32x32 的像素块，共有 6 个立方体面。
-	glDispatchCompute(envTextureUnfiltered.mWidth / 32, envTextureUnfiltered.mHeight / 32, 6);
+	glDispatchCompute(envTextureUnfiltered.mWidth / gComputeGroupSize, envTextureUnfiltered.mHeight / gComputeGroupSize, 6);
 	glDeleteTextures(1, &envTextureEquirect.mId);
 	glDeleteProgram(equirectToCubeProgram);
 	glGenerateTextureMipmap(envTextureUnfiltered.mId);		// 生成未过滤的环境立方体贴图的mipmap。
@@ -270,7 +1667,7 @@ Texture Renderer::ComputePreFilteredSpecularMap(Texture& envUnfilteredT, int gEn
 	 **************************************************************/
 
 	// 链接并编译着色器程序，用于计算预过滤的镜面环境贴图。
-	GLuint spmapProgram = Shader::LinkProgram({ "spmap.comp" });
+	GLuint spmapProgram = Shader::LinkProgram({ "spmap.comp" }, PrecomputeVariant(gSpecularSamples));
 	// 创建一个立方体贴图纹理，大小为 gEnvMapSize x gEnvMapSize，格式为 GL_RGBA16F。
 	Texture mEnvTexture = Texture(GL_TEXTURE_CUBE_MAP, gEnvMapSize, gEnvMapSize, GL_RGBA16F);
 
@@ -290,7 +1687,7 @@ Texture Renderer::ComputePreFilteredSpecularMap(Texture& envUnfilteredT, int gEn
 	// 预过滤剩余的mipmap链。
 	const float deltaRoughness = 1.0f / glm::max(float(mEnvTexture.mLevel - 1), 1.0f);
 	for (int level = 1, size = gEnvMapSize / 2; level <= mEnvTexture.mLevel; ++level, size /= 2) {
-		const GLuint numGroups = glm::max(1, size / 32);
+		const GLuint numGroups = glm::max(1, size / gComputeGroupSize);
 
 		// 绑定目标环境贴图的指定级别到图像单元0，用于写操作，格式为 GL_RGBA16F。
 		glBindImageTexture(
@@ -319,7 +1716,7 @@ Texture Renderer::ComputePreFilteredSpecularMap(Texture& envUnfilteredT, int gEn
 Texture Renderer::ComputeDiffuseIrradianceCubemap(const Texture& mEnvTexture, int gIrradianceMapSize)
 {
 	// 链接并编译着色器程序，用于计算漫反射辐照度立方体贴图。
-	GLuint irmapProgram = Shader::LinkProgram({ "irmap.comp" });
+	GLuint irmapProgram = Shader::LinkProgram({ "irmap.comp" }, PrecomputeVariant(gIrradianceSamples));
 	// 创建一个立方体贴图纹理，大小为 gIrradianceMapSize x gIrradianceMapSize，格式为 GL_RGBA16F。
 	Texture mIrmapTexture = Texture(GL_TEXTURE_CUBE_MAP, gIrradianceMapSize, gIrradianceMapSize, GL_RGBA16F, 1);
 
@@ -343,7 +1740,7 @@ Texture Renderer::ComputeDiffuseIrradianceCubemap(const Texture& mEnvTexture, in
 	// 启动计算着色器进行漫反射辐照度立方体贴图的计算。
 	// 计算着色器会被分配的工作组数为 (mIrmapTexture.mWidth / 32) x (mIrmapTexture.mHeight / 32) x 6。
 	// 这里每个工作组处理 32x32 的像素块，共有 6 个立方体面。
-	glDispatchCompute(mIrmapTexture.mWidth / 32, mIrmapTexture.mHeight / 32, 6);
+	glDispatchCompute(mIrmapTexture.mWidth / gComputeGroupSize, mIrmapTexture.mHeight / gComputeGroupSize, 6);
 
 	// 删除着色器程序，以释放资源。
 	glDeleteProgram(irmapProgram);
@@ -354,7 +1751,7 @@ Texture Renderer::ComputeDiffuseIrradianceCubemap(const Texture& mEnvTexture, in
 Texture Renderer::ComputeCookTorranceBRDF_LUT(int gBRDF_LUT_Size) 
 {
 	// 链接并编译着色器程序，用于计算 Cook-Torrance BRDF 2D LUT。
-	GLuint spBRDFProgram = Shader::LinkProgram({ "spbrdf.comp" });
+	GLuint spBRDFProgram = Shader::LinkProgram({ "spbrdf.comp" }, PrecomputeVariant(gBRDFSamples));
 
 	// 创建一个2D纹理，大小为 gBRDF_LUT_Size x gBRDF_LUT_Size，格式为 GL_RG16F。
 	Texture mSpBRDF_LUT = Texture(GL_TEXTURE_2D, gBRDF_LUT_Size, gBRDF_LUT_Size, GL_RG16F, 1);
@@ -380,7 +1777,7 @@ Texture Renderer::ComputeCookTorranceBRDF_LUT(int gBRDF_LUT_Size)
 	// 启动计算着色器进行 Cook-Torrance BRDF 2D LUT 的计算。
 	// 计算着色器会被分配的工作组数为 (mSpBRDF_LUT.mWidth / 32) x (mSpBRDF_LUT.mHeight / 32) x 1。
 	// 这里每个工作组处理 32x32 的像素块。
-	glDispatchCompute(mSpBRDF_LUT.mWidth / 32, mSpBRDF_LUT.mHeight / 32, 1);
+	glDispatchCompute(mSpBRDF_LUT.mWidth / gComputeGroupSize, mSpBRDF_LUT.mHeight / gComputeGroupSize, 1);
 
 	// 删除着色器程序，以释放资源。
 	glDeleteProgram(spBRDFProgram);
@@ -2,12 +2,20 @@
 #ifndef __RENDERER_H__
 #define __RENDERER_H__
 
+#include <atomic>
 #include <string>
 #include <glad/glad.h>
 #include "Buffer.h"
+#include "GpuTimer.h"
+#include "DrawQueue.h"
+#include "FramePacer.h"
+#include "RenderGraph.h"
 #include "RendererInterface.h"
+#include "ResourceManager.h"
 #include "Texture.h"
 
+class Image;
+
 class Renderer final : public RendererInterface
 {
 public:
@@ -16,16 +24,34 @@ public:
 
 public:
 	void Clear() override;
-	void RenderFrame(GLFWwindow* window, const ViewSettings& view, const SceneSettings& scene) override;
+	void RenderFrame(GLFWwindow* window, const ViewSettings& view, const SceneSettings& scene, double inputTime) override;
+	void WaitForNextFrame() override;
+	void SetRenderPath(RenderPath path) override;
+	RenderPath GetRenderPath() const override { return mRenderPath; }
+	bool NeedsRedraw() override;
+	void PresentLastFrame(GLFWwindow* window) override;
+	void RequestRenderGraphDump() override;
+	void RequestTextureMemoryReport() override;
+
+	 /********************************************************************************
+	 * @brief		在球内随机生成局部光源，约四分之一为指向球心的聚光灯
+	 *********************************************************************************
+	 * @param		count 光源数量
+	 * @param		radius 分布球的半径（以原点为中心）
+	 * @param		seed 随机种子，相同的种子得到相同的光源
+	 * @return		生成的局部光源
+	 ********************************************************************************/
+	static std::vector<SceneSettings::LocalLight> CreateLightField(int count, float radius, uint32_t seed);
 
 private:
 
 	 /********************************************************************************
-	 * @brief		加载并将等矩形环境贴图转换为立方体贴图纹理。
+	 * @brief		将等矩形环境贴图转换为立方体贴图纹理。
 	 *********************************************************************************
+	 * @param		equirect 已解码的等矩形 HDR 环境贴图
 	 * @return      立方体贴图纹理
 	 ********************************************************************************/
-	Texture LoadAndConvertEquirectangularToCubemap();
+	Texture LoadAndConvertEquirectangularToCubemap(const Image& equirect);
 
 	 /********************************************************************************
 	 * @brief		计算预过滤的镜面环境贴图
@@ -53,32 +79,213 @@ private:
 	 ********************************************************************************/
 	Texture ComputeCookTorranceBRDF_LUT(int gBRDF_LUT_Size);
 
+	// 着色器热重载：有程序被替换时丢弃依赖它们的状态，返回是否需要重新渲染
+	bool ReloadShaders();
+
+	// 根据 GPU 计时查询环的结果调整 mRenderScale，使 GPU 帧时间接近 gTargetFrameMs
+	void UpdateDynamicResolution();
+
+	 /********************************************************************************
+	 * @brief		决定本帧是否使用深度预通道。Auto 模式下取回已完成的样本数查询，按测得的过度绘制切换，
+	 *				并定期以另一种方式渲染一帧来更新测量
+	 *********************************************************************************
+	 * @return		本帧是否先绘制深度预通道
+	 ********************************************************************************/
+	bool UpdateDepthPrepass();
+
+	 /********************************************************************************
+	 * @brief		更新方向光的级联阴影：计算每一级的矩阵，与缓存的内容比较，最近一级变化后立即重新渲染，
+	 *				较远的级联按轮转每帧最多重新渲染一级，并上传实际使用的矩阵
+	 *********************************************************************************
+	 * @param		scene 场景设置，启用的光源按 ShadingUB 的顺序紧凑排列
+	 * @param		sceneRotationMatrix 本帧的场景旋转矩阵
+	 ********************************************************************************/
+	void UpdateShadowMaps(const SceneSettings& scene, const glm::mat4& sceneRotationMatrix);
+
+	// 把绘制队列的阴影通道渲染到阴影图数组的一层，sceneToShadow 为光源的裁剪空间 * 场景旋转
+	void RenderShadowCascade(int layer, const glm::mat4& sceneToShadow);
+
+	// 丢弃全部缓存的阴影图，下一帧重新渲染（例如阴影程序被热重载）
+	void InvalidateShadowCache();
+
+	// 上传局部光源（最多 gMaxLocalLights 个）到存储缓冲区
+	void UploadLocalLights(const std::vector<SceneSettings::LocalLight>& lights);
+
+	// 以本帧的视图和投影矩阵更新簇参数，并运行计算着色器把局部光源分配到各个簇
+	void BuildLightClusters();
+
+	// 在日志中输出 MSAA 与 TAA 两种模式的渲染目标显存和每帧带宽估算，以及所选颜色格式在 1080p 与 4K 下的节省
+	void LogRenderTargetBudget(int samples);
+
+	 /********************************************************************************
+	 * @brief		前向渲染场景：可选的深度预通道、PBR 模型和天空盒
+	 *********************************************************************************
+	 * @param		renderWidth 本帧的渲染宽度
+	 * @param		renderHeight 本帧的渲染高度
+	 * @param		target 场景目标（颜色 + 深度模板，TAA 模式下还有运动向量）
+	 ********************************************************************************/
+	void RenderForward(int renderWidth, int renderHeight, const RenderTarget& target);
+
+	 /********************************************************************************
+	 * @brief		可见性缓冲区的光栅化：只写入实例与三角形编号和深度，没有几何的像素为 0
+	 *********************************************************************************
+	 * @param		renderWidth 本帧的渲染宽度
+	 * @param		renderHeight 本帧的渲染高度
+	 * @param		visibility 可见性目标（R32UI + 深度模板）
+	 ********************************************************************************/
+	void RasterizeVisibility(int renderWidth, int renderHeight, const RenderTarget& visibility);
+
+	 /********************************************************************************
+	 * @brief		可见性缓冲区的着色：计算着色器对每个像素重建属性并着色一次，没有几何的像素写入天空
+	 *********************************************************************************
+	 * @param		renderWidth 本帧的渲染宽度
+	 * @param		renderHeight 本帧的渲染高度
+	 * @param		visibility RasterizeVisibility 写入的可见性目标
+	 * @param		color 单样本的场景颜色目标（TAA 模式下还有运动向量）
+	 ********************************************************************************/
+	void ShadeVisibility(int renderWidth, int renderHeight, const RenderTarget& visibility, const RenderTarget& color);
+
+	// 绑定 PBR 着色所用的材质纹理与 IBL 纹理
+	void BindMaterialTextures();
+
+	// 在不透明几何之后绘制天空盒，深度固定在远平面并以 GL_LEQUAL 测试
+	void DrawSkybox();
+
+	 /********************************************************************************
+	 * @brief		把本帧场景中的模型加入绘制队列（阴影、深度预通道、不透明与可见性缓冲区通道），排序并合并
+	 *********************************************************************************
+	 * @param		sceneRotationMatrix 本帧的场景旋转矩阵
+	 * @param		eyePosition 视点位置，用于由近到远排序
+	 ********************************************************************************/
+	void QueueSceneDraws(const glm::mat4& sceneRotationMatrix, const glm::vec3& eyePosition);
+
+	// 不经过绘制队列绘制一个 PBR 模型（对比测试），vertexPulling 为 true 时从网格缓冲区池拉取顶点
+	void DrawPbrModel(bool vertexPulling);
+
+	 /********************************************************************************
+	 * @brief		gRunBenchmarks 开启时在第一帧运行的渲染路径对比测试，结果输出到日志
+	 *********************************************************************************
+	 * @param		scene 场景设置
+	 * @param		renderWidth 本帧的渲染宽度
+	 * @param		renderHeight 本帧的渲染高度
+	 * @param		target 本帧前向渲染的场景目标，测试结束后其内容与正常渲染一致
+	 ********************************************************************************/
+	void RunBenchmarks(const SceneSettings& scene, int renderWidth, int renderHeight, const RenderTarget& target);
+
+	// 命令列表的录制扩展性测试：16384 次绘制分成 1~16 个列表并行录制，输出录制与回放时间
+	void BenchmarkCommandLists();
+
+	// 以前向渲染和可见性缓冲区分别渲染本帧的场景，比较 GPU 时间；可见性缓冲区使用临时分配的目标
+	void BenchmarkRenderPaths(int renderWidth, int renderHeight, const RenderTarget& target);
+
+	 /********************************************************************************
+	 * @brief		分簇光照的对比测试：光源数量从 1 到 gMaxLocalLights，分别在固定体积（密度增长）
+	 *				和与数量成正比的体积（密度不变）中分布，输出簇构建与 PBR 通道的 GPU 时间及每簇光源数
+	 *********************************************************************************
+	 * @param		scene 场景设置，测试结束后恢复其中的局部光源并重新绘制本帧
+	 ********************************************************************************/
+	void BenchmarkClusteredLights(const SceneSettings& scene);
+
+	// 用管线统计查询比较天空盒先绘制（无深度测试）与后绘制（深度剔除）的片元着色器调用次数
+	void BenchmarkSkyboxOrder();
+
+	// 比较 R11G11B10F 与 RGBA16F 参考格式的精度：线性误差、色调映射后 8 位输出的色带与灰阶色偏
+	void TestColorPrecision();
+
 #if _DEBUG
 	static void LogMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
 #endif
 
 
-	FrameBuffer mFreameBuffer;			// 帧缓冲对象
-	FrameBuffer mResolveFramebuffer;	// 解析帧缓冲对象
+	RenderGraph mRenderGraph;			// 每帧的通道与临时渲染目标（场景、解析、可见性缓冲区）
+	RenderTargetDesc mSceneDesc;		// 前向渲染场景目标的描述，按最大渲染分辨率
+	RenderTarget mHistoryTargets[2];	// TAA 历史帧，交替作为输入和输出，作为导入目标参与帧图
+	RenderTarget mPresentTarget;		// 按需渲染时保存色调映射的结果（显示分辨率），空闲时重新呈现；否则为默认帧缓冲
+	std::atomic<bool> mDumpRenderGraph{ false };	// 下一帧之后写出帧图
+	std::atomic<bool> mTextureMemoryReport{ false };	// 下一帧之后输出纹理显存报告
 	MeshBuffer mSkybox;					// 天空盒网格缓冲
 	MeshBuffer mPbrModel;				// PBR模型网格缓冲
+	MeshArena mMeshArena;				// 顶点拉取路径的网格缓冲区池
+	MeshBuffer mPbrModelPulled;			// PBR模型在网格缓冲区池中的位置
+	MeshBuffer mPbrDepthModel;			// PBR模型只含位置的顶点流（深度预通道）
+	DrawQueue mDrawQueue;				// 每帧排序、合并的绘制
+	DrawMaterial mPbrMaterial;			// PBR 模型的材质纹理
 	GLuint mEmptyVAO;					// 空的顶点数组对象
 	GLuint mTonemapProgram;				// 色调映射程序
+	GLuint mTaaProgram = 0;				// 时间性抗锯齿程序
 	GLuint mSkyboxProgram;				// 天空盒程序
-	GLuint mPbrProgram;					// PBR程序
+	GLuint mDepthProgram = 0;			// 深度预通道程序
+	GLuint mVisibilityProgram = 0;		// 可见性缓冲区的光栅化程序
+	GLuint mVisibilityShadeProgram = 0;	// 可见性缓冲区的着色计算程序（当前光源数量对应的变体）
+	GLuint mVisibilityTonemapProgram = 0;	// 可见性缓冲区路径的单样本色调映射程序
+	RenderPath mRenderPath = RenderPath::Forward;
+	GLuint mPbrProgram;					// PBR程序（当前光源数量对应的变体，由 Shader 的变体缓存持有）
+	int mPbrLightCount;					// mPbrProgram 对应的启用光源数量
 
 	Texture mEnvTexture;				// 环境贴图纹理
 	Texture mIrmapTexture;				// 辐照度贴图纹理
 	Texture mSpBRDF_LUT;				// 镜面BRDF查找表纹理
-	Texture mAlbedoTexture;				// 反照率纹理
-	Texture mNormalTexture;				// 法线纹理
-	Texture mMetalnessTexture;			// 金属度纹理
-	Texture mRoughnessTexture;			// 粗糙度纹理
+	ResourceManager mResources;			// 引用计数、去重的材质纹理
+	TextureHandle mAlbedoTexture;		// 反照率纹理
+	TextureHandle mNormalTexture;		// 法线纹理
+	TextureHandle mMetalnessTexture;	// 金属度纹理
+	TextureHandle mRoughnessTexture;	// 粗糙度纹理
 
 	GLuint mTransformUB;				// 变换统一缓冲对象
 	GLuint mShadingUB;					// 光照统一缓冲对象
+	GLuint mClusterUB;					// 分簇光照的统一缓冲对象
+
+	// 一级阴影图的缓存状态：渲染时使用的矩阵与场景旋转，两者不变时缓存内容仍然有效
+	struct ShadowCascade
+	{
+		glm::mat4 matrix{ 1.0f };
+		glm::mat4 sceneRotation{ 1.0f };
+		bool valid = false;
+	};
+	static constexpr int mkMaxShadowCascades = 4;	// 与 shadows.glsl 中的 MaxShadowCascades 一致
+	ShadowCascade mShadowCascades[SceneSettings::NumLights][mkMaxShadowCascades];	// 按场景光源序号，与阴影图的层一致
+	GLuint mShadowUB = 0;				// 级联阴影的统一缓冲对象
+	GLuint mShadowTexture = 0;			// 阴影图数组，每个光源 gShadowCascades 层
+	GLuint mShadowFramebuffer = 0;		// 渲染阴影图时挂接其中一层
+	GLuint mShadowProgram = 0;			// 阴影图的深度程序
+	int mShadowCursor = 0;				// 较远级联的轮转位置
+	uint64_t mShadowCascadeRenders = 0;	// 累计重新渲染的级联数量
+	uint64_t mShadowCascadeSlots = 0;	// 每帧都重新渲染时的累计数量
+	bool mShadowUpdatesPending = false;	// 还有等待轮转的级联
+
+	GLuint mClusterProgram;				// 把局部光源分配到簇的计算程序
+	GLuint mLocalLightSB;				// 局部光源存储缓冲区
+	GLuint mClusterLightCounts;			// 每个簇的光源数量
+	GLuint mClusterLightIndices;		// 每个簇的光源索引，每簇 gClusterMaxLights 个槽位
+	int mLocalLightCount = 0;			// 已上传的局部光源数量
+	glm::mat4 mViewMatrix;				// 本帧的视图矩阵与投影矩阵，用于构建簇
+	glm::mat4 mProjectionMatrix;
 
 	bool mIsSrc = true;
+	bool mBenchmarksDone = false;		// 对比测试只运行一次
+	bool mRedrawRequested = false;		// 渲染器状态改变（例如切换渲染路径），需要渲染新的一帧
+	int mStillFrames = 0;				// 视图与场景旋转连续不变的帧数
+
+	GpuTimer mFrameTimer;				// 每帧的 GPU 计时
+	FramePacer mFramePacer;				// 限制 CPU 领先 GPU 的帧数并统计输入延迟
+	float mRenderScale = 1.0f;			// 当前内部渲染分辨率与显示分辨率之比
+	float mGpuFrameMs = 0.0f;			// 平滑后的 GPU 帧时间
+	int mFramesSinceResize = 0;			// 上次调整分辨率之后的帧数
+
+	bool mDepthPrepass = false;			// Auto 模式下当前是否使用深度预通道
+	GLuint mOverdrawQuery = 0;			// PBR 通道通过深度测试的样本数查询
+	bool mOverdrawQueryPending = false;	// 查询已提交、结果尚未取回
+	bool mOverdrawQueryPrepass = false;	// 查询所在帧是否使用了深度预通道
+	double mOverdrawQueryPixels = 1.0;	// 查询所在帧的渲染像素数
+	double mShadedSamples[2] = { 0.0, 0.0 };	// 没有/有预通道时每像素通过深度测试的样本数，0 表示尚未测量
+	uint32_t mShadedSamplesFrame[2] = { 0, 0 };	// 对应测量的帧序号
+
+	uint32_t mFrameIndex = 0;			// 帧序号，用于 TAA 抖动序列与历史目标的交替
+	glm::mat4 mPrevViewProjection;		// 上一帧的矩阵与抖动，用于计算运动向量
+	glm::mat4 mPrevSkyProjection;
+	glm::mat4 mInverseSkyProjection;	// 本帧天空投影矩阵的逆，可见性缓冲区着色时由像素求天空方向
+	glm::mat4 mPrevSceneRotation;
+	glm::vec2 mPrevJitter;
 
 };
 
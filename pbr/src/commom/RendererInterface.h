@@ -2,6 +2,7 @@
 #ifndef __RENDERERINTERFACE_H__
 #define __RENDERERINTERFACE_H__
 
+#include <vector>
 #include <glm/mat4x4.hpp>
 
 struct GLFWwindow;
@@ -25,8 +26,22 @@ struct SceneSettings
 		glm::vec3 radiance;
 		bool enabled = false;
 	} lights[NumLights];
+
+	// 局部光源，由分簇前向渲染按所在的视锥体素着色。位置为渲染所用的世界空间（含模型矩阵）
+	struct LocalLight {
+		glm::vec3 position{ 0.0f };
+		float range = 0.0f;			// 影响半径，衰减在此处平滑地降为 0
+		glm::vec3 radiance{ 0.0f };
+		glm::vec3 direction{ 0.0f, 0.0f, -1.0f };	// 聚光灯的朝向
+		float cosInner = -1.0f;		// 聚光灯内外锥角的余弦；默认值使任何方向的系数都为 1，即点光源
+		float cosOuter = -2.0f;
+	};
+	std::vector<LocalLight> localLights;
 };
 
+// 渲染路径：前向渲染；或者可见性缓冲区，光栅化只写入实例与三角形编号，之后每个像素只着色一次
+enum class RenderPath { Forward, VisibilityBuffer };
+
 class RendererInterface
 {
 public:
@@ -37,7 +52,27 @@ public:
 	virtual ~RendererInterface() = default;
 
 	virtual void Clear() = 0;
-	virtual void RenderFrame(GLFWwindow* window, const ViewSettings& view, const SceneSettings& scene) = 0;
+	// inputTime 为本帧依据的第一个输入事件的时间（glfwGetTime），小于 0 表示没有新的输入，用于统计延迟
+	virtual void RenderFrame(GLFWwindow* window, const ViewSettings& view, const SceneSettings& scene, double inputTime) = 0;
+
+	// 帧节奏：等待 CPU 可以开始新的一帧（在途帧数与帧率限制），应在取得本帧的输入之前调用
+	virtual void WaitForNextFrame() = 0;
+
+	// 运行时切换渲染路径，两条路径渲染相同的场景
+	virtual void SetRenderPath(RenderPath path) = 0;
+	virtual RenderPath GetRenderPath() const = 0;
+
+	// 按需渲染：视图与场景没有变化时，渲染器自身是否仍需要渲染新的一帧（着色器热重载、TAA 收敛、阴影级联的轮转更新等）
+	virtual bool NeedsRedraw() = 0;
+
+	// 重新呈现上一帧色调映射的结果，不重新渲染场景
+	virtual void PresentLastFrame(GLFWwindow* window) = 0;
+
+	// 下一帧渲染之后把帧图（通道、渲染目标与每个通道的 GPU 时间）写入 render_graph.dot，可以从其他线程调用
+	virtual void RequestRenderGraphDump() = 0;
+
+	// 下一帧之后把每个纹理的常驻级别、显存与最近使用的帧输出到日志，可以从其他线程调用
+	virtual void RequestTextureMemoryReport() = 0;
 };
 
 #endif // !__RENDERERINTERFACE_H__
\ No newline at end of file
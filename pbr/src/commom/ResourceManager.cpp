@@ -0,0 +1,753 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <type_traits>
+#include "ResourceManager.h"
+#include "Image.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "Path.h"
+#include "FrameArena.h"
+
+namespace {
+	constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+	constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		// FNV-1a，按 8 字节为单位混合，几兆字节的贴图在解码任务中散列
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + i, sizeof(word));
+			hash = (hash ^ word) * kFnvPrime;
+		}
+		for (; i < size; ++i)
+		{
+			hash = (hash ^ bytes[i]) * kFnvPrime;
+		}
+		return hash;
+	}
+
+	// 常见内部格式每个纹素的显存，三通道格式按驱动通常的四字节对齐计算
+	size_t TexelBytes(GLenum iformat)
+	{
+		switch (iformat)
+		{
+		case GL_R8:
+			return 1;
+		case GL_RG8:
+		case GL_R16F:
+			return 2;
+		case GL_RGB8:
+		case GL_SRGB8:
+		case GL_RGBA8:
+		case GL_SRGB8_ALPHA8:
+		case GL_RG16F:
+		case GL_R32F:
+			return 4;
+		case GL_RGB16F:
+		case GL_RGBA16F:
+		case GL_RG32F:
+			return 8;
+		case GL_RGB32F:
+		case GL_RGBA32F:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	size_t PixelBytes(const Image& image)
+	{
+		return static_cast<size_t>(image.mWidth) * image.mHeight * image.mChannels * (image.mIsHDR ? sizeof(float) : 1);
+	}
+
+	int MipLevels(int width, int height, int requested)
+	{
+		return requested ? requested : 1 + static_cast<int>(std::floor(std::log2(std::max(width, height))));
+	}
+
+	float LinearToSrgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// sRGB 格式的颜色通道在线性空间中平均，与 glGenerateTextureMipmap 的结果一致
+	const std::array<float, 256>& SrgbToLinear()
+	{
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> values;
+			for (int i = 0; i < 256; ++i)
+			{
+				const float value = i / 255.0f;
+				values[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+			}
+			return values;
+		}();
+		return table;
+	}
+
+	// 2x2 盒式滤波生成下一级，奇数边长时最后一行（列）重复取样；前 srgbChannels 个通道按 sRGB 处理
+	template<typename T>
+	void Downsample(const T* src, int srcWidth, int srcHeight, T* dst, int width, int height, int channels, int srgbChannels)
+	{
+		const std::array<float, 256>& toLinear = SrgbToLinear();
+		for (int y = 0; y < height; ++y)
+		{
+			const int y0 = std::min(2 * y, srcHeight - 1);
+			const int y1 = std::min(2 * y + 1, srcHeight - 1);
+			for (int x = 0; x < width; ++x)
+			{
+				const int x0 = std::min(2 * x, srcWidth - 1);
+				const int x1 = std::min(2 * x + 1, srcWidth - 1);
+				const T* a = src + (static_cast<size_t>(y0) * srcWidth + x0) * channels;
+				const T* b = src + (static_cast<size_t>(y0) * srcWidth + x1) * channels;
+				const T* c = src + (static_cast<size_t>(y1) * srcWidth + x0) * channels;
+				const T* d = src + (static_cast<size_t>(y1) * srcWidth + x1) * channels;
+				T* out = dst + (static_cast<size_t>(y) * width + x) * channels;
+				for (int i = 0; i < channels; ++i)
+				{
+					if constexpr (std::is_same_v<T, float>)
+					{
+						out[i] = (a[i] + b[i] + c[i] + d[i]) * 0.25f;
+					}
+					else if (i < srgbChannels)
+					{
+						const float linear = (toLinear[a[i]] + toLinear[b[i]] + toLinear[c[i]] + toLinear[d[i]]) * 0.25f;
+						out[i] = static_cast<T>(std::lround(std::clamp(LinearToSrgb(linear), 0.0f, 1.0f) * 255.0f));
+					}
+					else
+					{
+						out[i] = static_cast<T>((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+
+	// 像素与上传参数共同决定纹理内容：同一图像以不同格式上传是不同的纹理
+	uint64_t ContentKey(const Image& image, const TextureRequest& request)
+	{
+		uint64_t hash = HashBytes(kFnvOffset, image.GetPixels<uint8_t>(), PixelBytes(image));
+		const int64_t params[] = { image.mWidth, image.mHeight, image.mChannels, image.mIsHDR, request.format, request.iformat, request.levels };
+		return HashBytes(hash, params, sizeof(params));
+	}
+}
+
+void ResourceManager::Init(size_t budgetBytes)
+{
+	mBudget = budgetBytes;
+	// 释放列表预留容量，稳态帧中释放纹理不需要扩容
+	mReleased.reserve(64);
+	mRetired.reserve(64);
+	mPending.reserve(8);
+}
+
+void ResourceManager::Delete()
+{
+	LogMemoryReport();
+	glFinish();
+	for (PendingRelease& pending : mPending)
+	{
+		glDeleteSync(pending.fence);
+		glDeleteTextures(static_cast<GLsizei>(pending.textures.size()), pending.textures.data());
+		for (uint32_t index : pending.slots)
+		{
+			Destroy(index);
+		}
+	}
+	mPending.clear();
+	for (uint32_t index : mReleased)
+	{
+		Destroy(index);
+	}
+	mReleased.clear();
+	glDeleteTextures(static_cast<GLsizei>(mRetired.size()), mRetired.data());
+	mRetired.clear();
+
+	size_t leaked = 0;
+	for (uint32_t index = 0; index < mSlots.size(); ++index)
+	{
+		if (mSlots[index].live)
+		{
+			++leaked;
+			Destroy(index);
+		}
+	}
+	if (leaked > 0)
+	{
+		LOG_WARN(std::format("Resource manager: {} textures were still referenced at shutdown", leaked));
+	}
+	LogStatistics();
+
+	mSlots.clear();
+	mFreeSlots.clear();
+	mByPath.clear();
+	mByContent.clear();
+}
+
+std::vector<TextureHandle> ResourceManager::LoadTextures(std::span<const TextureRequest> requests)
+{
+	const size_t npos = static_cast<size_t>(-1);
+	std::vector<TextureHandle> handles(requests.size());
+	std::vector<std::string> keys(requests.size());
+	std::vector<size_t> sameAs(requests.size(), npos);	// 批内重复的路径：与之前的哪个请求相同
+	std::vector<size_t> misses;
+	std::unordered_map<std::string_view, size_t> batchMisses;
+
+	// 路径去重：已加载或在本批中已经请求过的路径不再解码
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		keys[i] = PathKey(requests[i]);
+	}
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		if (auto loaded = mByPath.find(keys[i]); loaded != mByPath.end())
+		{
+			handles[i] = AddRef({ loaded->second, mSlots[loaded->second].generation });
+			++mPathHits;
+		}
+		else if (auto earlier = batchMisses.find(keys[i]); earlier != batchMisses.end())
+		{
+			sameAs[i] = earlier->second;
+			++mPathHits;
+		}
+		else
+		{
+			batchMisses.emplace(keys[i], i);
+			misses.push_back(i);
+		}
+	}
+
+	// 解码、生成 MIPMAP 链与内容散列并行执行，失败时 ParallelFor 重新抛出第一个错误
+	std::vector<std::unique_ptr<Stream>> streams(misses.size());
+	std::vector<uint64_t> contentKeys(misses.size());
+	JobSystem::ParallelFor("Decode texture", misses.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t k = begin; k < end; ++k)
+		{
+			const TextureRequest& request = requests[misses[k]];
+			streams[k] = DecodeStream(request, request.levels);
+			contentKeys[k] = ContentKey(*streams[k]->image, request);
+		}
+	});
+
+	// 上传：内容与已有纹理相同（例如另存为不同文件名的同一贴图）时复用，只登记新的路径
+	for (size_t k = 0; k < misses.size(); ++k)
+	{
+		const size_t i = misses[k];
+		const Image& image = *streams[k]->image;
+		const TextureRequest& request = requests[i];
+
+		uint32_t index;
+		if (auto same = mByContent.find(contentKeys[k]); same != mByContent.end()
+			&& mSlots[same->second].width == image.mWidth && mSlots[same->second].height == image.mHeight)
+		{
+			index = same->second;
+			Slot& slot = mSlots[index];
+			++slot.refs;
+			++mContentHits;
+			mSavedBytes += TextureBytes(request.iformat, slot.width, slot.height, 0, slot.levels);
+		}
+		else
+		{
+			index = AllocateSlot();
+			Slot& slot = mSlots[index];
+			const Texture texture(GL_TEXTURE_2D, image.mWidth, image.mHeight, request.iformat, request.levels);
+			slot.source = request;
+			slot.width = image.mWidth;
+			slot.height = image.mHeight;
+			slot.levels = texture.mLevel;
+			slot.refs = 1;
+			slot.lastUsed = mFrame;
+			slot.contentKey = contentKeys[k];
+			SetTexture(slot, texture, 0);
+			mByContent[contentKeys[k]] = index;
+
+			// 完整尺寸的存储只立即填充 MIPMAP 尾部，纹理马上可以使用，更精细的级别之后逐帧上传
+			const int tail = TailLevel(slot.width, slot.height, slot.levels);
+			slot.stream = std::move(streams[k]);
+			slot.stream->nextLevel = slot.levels - 1;
+			while (slot.stream->nextLevel >= tail)
+			{
+				UploadRows(slot, SIZE_MAX);
+			}
+			if (slot.stream->nextLevel < 0)
+			{
+				slot.stream.reset();
+			}
+			else
+			{
+				++mStreaming;
+			}
+			++mUploads;
+			mUploadedBytes += slot.bytes;
+		}
+		mSlots[index].pathKeys.push_back(keys[i]);
+		mByPath[keys[i]] = index;
+		handles[i] = { index, mSlots[index].generation };
+	}
+
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		if (sameAs[i] != npos)
+		{
+			handles[i] = AddRef(handles[sameAs[i]]);
+			const Slot& slot = mSlots[handles[i].index];
+			mSavedBytes += TextureBytes(slot.source.iformat, slot.width, slot.height, 0, slot.levels);
+		}
+	}
+	return handles;
+}
+
+TextureHandle ResourceManager::LoadTexture(const TextureRequest& request)
+{
+	return LoadTextures({ &request, 1 })[0];
+}
+
+TextureHandle ResourceManager::AddRef(TextureHandle handle)
+{
+	LOG_ASSERT(!Get(handle), "AddRef on a stale texture handle");
+	++mSlots[handle.index].refs;
+	return handle;
+}
+
+void ResourceManager::Release(TextureHandle& handle)
+{
+	if (!handle.Valid()) return;
+	LOG_ASSERT(!Get(handle), "Release on a stale texture handle");
+	Slot& slot = mSlots[handle.index];
+	if (--slot.refs == 0)
+	{
+		// 不再能被查找到，纹理本身等到 GPU 用完之后销毁
+		for (const std::string& key : slot.pathKeys)
+		{
+			mByPath.erase(key);
+		}
+		slot.pathKeys.clear();
+		if (auto content = mByContent.find(slot.contentKey); content != mByContent.end() && content->second == handle.index)
+		{
+			mByContent.erase(content);
+		}
+		mReleased.push_back(handle.index);
+	}
+	handle = {};
+}
+
+GLuint ResourceManager::Get(TextureHandle handle) const
+{
+	if (handle.index >= mSlots.size()) return 0;
+	const Slot& slot = mSlots[handle.index];
+	return slot.generation == handle.generation && slot.refs > 0 ? slot.texture.mId : 0;
+}
+
+GLuint ResourceManager::Use(TextureHandle handle)
+{
+	const GLuint id = Get(handle);
+	if (!id) return 0;
+	Slot& slot = mSlots[handle.index];
+	slot.lastUsed = mFrame;
+	if (slot.trimmedLevels > 0 && !slot.restore && !slot.restoreFailed)
+	{
+		StartRestore(slot);
+	}
+	return id;
+}
+
+void ResourceManager::EndFrame()
+{
+	FinishRestores();
+	StreamUploads();
+	EnforceBudget();
+	CollectGarbage();
+	++mFrame;
+}
+
+void ResourceManager::CollectGarbage()
+{
+	if (!mReleased.empty() || !mRetired.empty())
+	{
+		mPending.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), mReleased, mRetired });
+		mReleased.clear();
+		mRetired.clear();
+	}
+
+	// 栅栏按插入顺序通过，遇到第一个未通过的即停止；不等待
+	size_t signaled = 0;
+	size_t destroyed = 0;
+	for (; signaled < mPending.size(); ++signaled)
+	{
+		PendingRelease& pending = mPending[signaled];
+		const GLenum status = glClientWaitSync(pending.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED) break;
+		glDeleteSync(pending.fence);
+		glDeleteTextures(static_cast<GLsizei>(pending.textures.size()), pending.textures.data());
+		for (uint32_t index : pending.slots)
+		{
+			Destroy(index);
+			++destroyed;
+		}
+	}
+	if (signaled > 0)
+	{
+		mPending.erase(mPending.begin(), mPending.begin() + signaled);
+	}
+	if (destroyed > 0)
+	{
+		LOG_INFO(std::format("Resource manager: destroyed {} released textures", destroyed));
+	}
+}
+
+bool ResourceManager::HasPendingWork() const
+{
+	return mRestoring > 0 || mStreaming > 0 || !mPending.empty() || !mReleased.empty() || !mRetired.empty();
+}
+
+void ResourceManager::LogStatistics() const
+{
+	LOG_INFO(std::format("Resource manager: {} uploads ({:.1f} MB, {:.1f} MB streamed), {} path hits, {} content hits, {:.1f} MB of uploads avoided, {} destroyed",
+		mUploads, mUploadedBytes / (1024.0 * 1024.0), mStreamedBytes / (1024.0 * 1024.0), mPathHits, mContentHits, mSavedBytes / (1024.0 * 1024.0), mDestroyed));
+}
+
+void ResourceManager::LogMemoryReport() const
+{
+	std::vector<const Slot*> live;
+	size_t fullBytes = 0;
+	for (const Slot& slot : mSlots)
+	{
+		if (slot.live && slot.refs > 0)
+		{
+			live.push_back(&slot);
+			fullBytes += TextureBytes(slot.source.iformat, slot.width, slot.height, 0, slot.levels);
+		}
+	}
+	std::sort(live.begin(), live.end(), [](const Slot* a, const Slot* b) { return a->bytes > b->bytes; });
+
+	LOG_INFO(std::format("Texture memory: {} textures, {:.2f} MB resident, {:.2f} MB at full resolution, budget {}; {} trims, {} restores",
+		live.size(), mResidentBytes / (1024.0 * 1024.0), fullBytes / (1024.0 * 1024.0),
+		mBudget ? std::format("{:.2f} MB", mBudget / (1024.0 * 1024.0)) : std::string("unlimited"), mTrims, mRestores));
+	for (const Slot* slot : live)
+	{
+		const std::string state = slot->stream ? std::format(" (streaming, base level {})", slot->stream->nextLevel + 1)
+			: slot->restore ? " (decoding to stream back)" : slot->restoreFailed ? " (trimmed, stream back failed)"
+			: slot->trimmedLevels > 0 ? " (trimmed)" : "";
+		LOG_INFO(std::format("  {}: {}x{}, levels {}/{}, {:.2f} MB, last used {} frames ago{}",
+			slot->source.path, slot->width, slot->height, slot->levels - slot->trimmedLevels, slot->levels,
+			slot->bytes / (1024.0 * 1024.0), mFrame - slot->lastUsed, state));
+	}
+}
+
+std::string ResourceManager::PathKey(const TextureRequest& request)
+{
+	// 文件系统不区分大小写，"textures/../textures/PBRA.png" 与 "textures/pbrA.png" 是同一文件
+	std::string path = std::filesystem::path(request.path).lexically_normal().generic_string();
+	std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return std::format("{}|{}|{}|{}|{}", path, request.channels, request.format, request.iformat, request.levels);
+}
+
+size_t ResourceManager::TextureBytes(GLenum iformat, int width, int height, int firstLevel, int levels)
+{
+	size_t bytes = 0;
+	for (int level = firstLevel; level < firstLevel + levels; ++level)
+	{
+		bytes += static_cast<size_t>(std::max(width >> level, 1)) * std::max(height >> level, 1);
+	}
+	return bytes * TexelBytes(iformat);
+}
+
+int ResourceManager::TailLevel(int width, int height, int levels)
+{
+	int level = 0;
+	while (level < levels - 1 && std::max(width >> level, height >> level) > gTextureTrimSize)
+	{
+		++level;
+	}
+	return level;
+}
+
+std::unique_ptr<ResourceManager::Stream> ResourceManager::DecodeStream(const TextureRequest& request, int levels)
+{
+	auto stream = std::make_unique<Stream>();
+	stream->image = Image::ReadFile(request.path, request.channels);
+	const Image& image = *stream->image;
+	const int count = MipLevels(image.mWidth, image.mHeight, levels);
+	const size_t pixelBytes = image.mChannels * (image.mIsHDR ? sizeof(float) : 1);
+	const int srgbChannels = (request.iformat == GL_SRGB8 || request.iformat == GL_SRGB8_ALPHA8) ? std::min(image.mChannels, 3) : 0;
+
+	stream->mips.resize(count - 1);
+	const uint8_t* src = image.GetPixels<uint8_t>();
+	for (int level = 1; level < count; ++level)
+	{
+		const int srcWidth = std::max(image.mWidth >> (level - 1), 1);
+		const int srcHeight = std::max(image.mHeight >> (level - 1), 1);
+		const int width = std::max(image.mWidth >> level, 1);
+		const int height = std::max(image.mHeight >> level, 1);
+		std::vector<uint8_t>& mip = stream->mips[level - 1];
+		mip.resize(static_cast<size_t>(width) * height * pixelBytes);
+		if (image.mIsHDR)
+		{
+			Downsample(reinterpret_cast<const float*>(src), srcWidth, srcHeight, reinterpret_cast<float*>(mip.data()), width, height, image.mChannels, 0);
+		}
+		else
+		{
+			Downsample(src, srcWidth, srcHeight, mip.data(), width, height, image.mChannels, srgbChannels);
+		}
+		src = mip.data();
+	}
+	return stream;
+}
+
+uint32_t ResourceManager::AllocateSlot()
+{
+	if (!mFreeSlots.empty())
+	{
+		const uint32_t index = mFreeSlots.back();
+		mFreeSlots.pop_back();
+		return index;
+	}
+	mSlots.emplace_back();
+	return static_cast<uint32_t>(mSlots.size() - 1);
+}
+
+void ResourceManager::Destroy(uint32_t index)
+{
+	Slot& slot = mSlots[index];
+	if (!slot.live) return;
+	if (slot.restore)
+	{
+		// 恢复任务引用 Restore，等它结束；释放前的解码错误不再重要
+		try
+		{
+			JobSystem::Wait(slot.restore->done);
+		}
+		catch (const std::exception&)
+		{
+		}
+		slot.restore.reset();
+		--mRestoring;
+	}
+	if (slot.stream)
+	{
+		slot.stream.reset();
+		--mStreaming;
+	}
+	slot.texture.DelTexture();
+	mResidentBytes -= slot.bytes;
+	slot.live = false;
+	slot.refs = 0;
+	slot.bytes = 0;
+	slot.trimmedLevels = 0;
+	slot.restoreFailed = false;
+	slot.pathKeys.clear();
+	// 代数跳过 0，保证默认构造的句柄永远无效
+	if (++slot.generation == 0)
+	{
+		slot.generation = 1;
+	}
+	mFreeSlots.push_back(index);
+	++mDestroyed;
+}
+
+void ResourceManager::SetTexture(Slot& slot, const Texture& texture, int trimmedLevels)
+{
+	if (slot.live)
+	{
+		// 旧的纹理对象可能仍被已提交的命令使用，与释放的纹理一样等栅栏通过后删除
+		mRetired.push_back(slot.texture.mId);
+		mResidentBytes -= slot.bytes;
+	}
+	slot.texture = texture;
+	slot.trimmedLevels = trimmedLevels;
+	slot.live = true;
+	slot.bytes = TextureBytes(slot.source.iformat, slot.width, slot.height, trimmedLevels, slot.levels - trimmedLevels);
+	mResidentBytes += slot.bytes;
+}
+
+void ResourceManager::Trim(Slot& slot)
+{
+	const int first = TailLevel(slot.width, slot.height, slot.levels);
+	if (first <= slot.trimmedLevels) return;
+
+	const int levels = slot.levels - first;
+	const Texture trimmed(GL_TEXTURE_2D, std::max(slot.width >> first, 1), std::max(slot.height >> first, 1), slot.source.iformat, levels);
+	for (int level = 0; level < levels; ++level)
+	{
+		glCopyImageSubData(slot.texture.mId, GL_TEXTURE_2D, first - slot.trimmedLevels + level, 0, 0, 0,
+			trimmed.mId, GL_TEXTURE_2D, level, 0, 0, 0,
+			std::max(trimmed.mWidth >> level, 1), std::max(trimmed.mHeight >> level, 1), 1);
+	}
+	SetTexture(slot, trimmed, first);
+	++mTrims;
+}
+
+void ResourceManager::EnforceBudget()
+{
+	if (mBudget == 0 || mResidentBytes <= mBudget)
+	{
+		mOverBudget = false;
+		return;
+	}
+
+	// 超出预算的帧每帧都会检查，候选列表来自帧分配器
+	FrameVector<uint32_t> cold;
+	for (uint32_t index = 0; index < mSlots.size(); ++index)
+	{
+		const Slot& slot = mSlots[index];
+		if (slot.live && slot.refs > 0 && !slot.restore && !slot.stream && slot.levels - slot.trimmedLevels > 1
+			&& slot.lastUsed + static_cast<uint32_t>(gTextureColdFrames) <= mFrame)
+		{
+			cold.push_back(index);
+		}
+	}
+	std::sort(cold.begin(), cold.end(), [this](uint32_t a, uint32_t b) { return mSlots[a].lastUsed < mSlots[b].lastUsed; });
+
+	const size_t before = mResidentBytes;
+	const size_t trims = mTrims;
+	for (uint32_t index : cold)
+	{
+		Trim(mSlots[index]);
+		if (mResidentBytes <= mBudget) break;
+	}
+	if (mTrims > trims)
+	{
+		LOG_INFO(std::format("Texture residency: trimmed {} cold textures, {:.2f} MB -> {:.2f} MB (budget {:.2f} MB)",
+			mTrims - trims, before / (1024.0 * 1024.0), mResidentBytes / (1024.0 * 1024.0), mBudget / (1024.0 * 1024.0)));
+	}
+	if (mResidentBytes > mBudget && !mOverBudget)
+	{
+		LOG_WARN(std::format("Texture residency: {:.2f} MB resident exceeds the {:.2f} MB budget and no cold textures are left to trim",
+			mResidentBytes / (1024.0 * 1024.0), mBudget / (1024.0 * 1024.0)));
+		mOverBudget = true;
+	}
+}
+
+void ResourceManager::StartRestore(Slot& slot)
+{
+	slot.restore = std::make_unique<Restore>();
+	Restore* restore = slot.restore.get();
+	JobSystem::Run("Restore texture", [restore, request = slot.source, levels = slot.levels]()
+	{
+		restore->stream = DecodeStream(request, levels);
+	}, &restore->done);
+	++mRestoring;
+	LOG_INFO(std::format("Texture residency: streaming back {} ({} of {} levels resident)",
+		slot.source.path, slot.levels - slot.trimmedLevels, slot.levels));
+}
+
+void ResourceManager::FinishRestores()
+{
+	if (mRestoring == 0) return;
+	for (Slot& slot : mSlots)
+	{
+		if (!slot.restore || !slot.restore->done.Done()) continue;
+		const std::unique_ptr<Restore> restore = std::move(slot.restore);
+		--mRestoring;
+		// 源文件在加载之后被删除或修改时解码失败：保留裁剪后的纹理，不再重试
+		try
+		{
+			JobSystem::Wait(restore->done);
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARN(std::format("Texture residency: failed to stream back {}, keeping {} of {} levels: {}",
+				slot.source.path, slot.levels - slot.trimmedLevels, slot.levels, e.what()));
+			slot.restoreFailed = true;
+			continue;
+		}
+		if (slot.refs == 0) continue;
+
+		// 重新分配完整尺寸的存储：已常驻的尾部直接复制，基础级别限制在尾部，更精细的级别流式上传
+		const int resident = slot.trimmedLevels;
+		const Texture full(GL_TEXTURE_2D, slot.width, slot.height, slot.source.iformat, slot.levels);
+		for (int level = resident; level < slot.levels; ++level)
+		{
+			glCopyImageSubData(slot.texture.mId, GL_TEXTURE_2D, level - resident, 0, 0, 0,
+				full.mId, GL_TEXTURE_2D, level, 0, 0, 0,
+				std::max(slot.width >> level, 1), std::max(slot.height >> level, 1), 1);
+		}
+		glTextureParameteri(full.mId, GL_TEXTURE_BASE_LEVEL, resident);
+		SetTexture(slot, full, 0);
+		slot.stream = std::move(restore->stream);
+		slot.stream->nextLevel = resident - 1;
+		slot.stream->nextRow = 0;
+		++mStreaming;
+		++mRestores;
+		LOG_INFO(std::format("Texture residency: {} decoded, streaming {} finer levels", slot.source.path, resident));
+	}
+}
+
+size_t ResourceManager::UploadRows(Slot& slot, size_t budget)
+{
+	Stream& stream = *slot.stream;
+	const Image& image = *stream.image;
+	const int level = stream.nextLevel;
+	const int width = std::max(slot.width >> level, 1);
+	const int height = std::max(slot.height >> level, 1);
+	const size_t rowBytes = static_cast<size_t>(width) * image.mChannels * (image.mIsHDR ? sizeof(float) : 1);
+	// 至少上传一行，预算小于一行时也能推进
+	const int rows = static_cast<int>(std::clamp<size_t>(budget / rowBytes, 1, height - stream.nextRow));
+	const uint8_t* pixels = (level == 0 ? image.GetPixels<uint8_t>() : stream.mips[level - 1].data()) + stream.nextRow * rowBytes;
+
+	// 单通道、三通道的行不一定按 4 字节对齐
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureSubImage2D(slot.texture.mId, level, 0, stream.nextRow, width, rows, slot.source.format,
+		image.mIsHDR ? GL_FLOAT : GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	stream.nextRow += rows;
+	if (stream.nextRow == height)
+	{
+		// 这一级完整之后才允许采样；它的像素不再需要
+		glTextureParameteri(slot.texture.mId, GL_TEXTURE_BASE_LEVEL, level);
+		if (level > 0)
+		{
+			std::vector<uint8_t>().swap(stream.mips[level - 1]);
+		}
+		--stream.nextLevel;
+		stream.nextRow = 0;
+	}
+	const size_t bytes = rows * rowBytes;
+	mStreamedBytes += bytes;
+	return bytes;
+}
+
+void ResourceManager::StreamUploads()
+{
+	if (mStreaming == 0) return;
+	size_t budget = gTextureUploadBudget;
+	while (budget > 0)
+	{
+		// 所有纹理中待上传级别最粗的优先，各纹理一起逐级变清晰
+		Slot* next = nullptr;
+		int nextWidth = INT_MAX;
+		for (Slot& slot : mSlots)
+		{
+			if (!slot.stream || slot.refs == 0) continue;
+			const int width = std::max(slot.width >> slot.stream->nextLevel, 1);
+			if (width < nextWidth)
+			{
+				next = &slot;
+				nextWidth = width;
+			}
+		}
+		if (!next) break;
+
+		budget -= std::min(budget, UploadRows(*next, budget));
+		if (next->stream->nextLevel < 0)
+		{
+			next->stream.reset();
+			--mStreaming;
+			LOG_INFO(std::format("Texture streaming: {} fully resident ({} levels)", next->source.path, next->levels));
+		}
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+#ifndef __RESOURCEMANAGER_H__
+#define __RESOURCEMANAGER_H__
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "JobSystem.h"
+#include "Texture.h"
+
+class Image;
+
+// 纹理句柄：槽位序号与代数。槽位中的纹理销毁后代数加一，旧句柄随之失效而不会指向复用槽位的新纹理；代数 0 表示无效句柄
+struct TextureHandle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0;
+
+	bool Valid() const { return generation != 0; }
+};
+
+// 一次纹理加载请求，参数与 Texture 的文件构造函数相同
+struct TextureRequest
+{
+	std::string path;		// 相对于资源目录的路径
+	int channels;
+	GLenum format;
+	GLenum iformat;
+	int levels = 0;			// 0 表示完整的 MIPMAP 链
+};
+
+// 引用计数的纹理管理器：同一路径（规范化后）的请求不重复解码，解码后像素内容相同的文件不重复上传，
+// 多个网格共用的材质纹理只占一份显存。句柄持有引用，引用归零的纹理在 CollectGarbage 插入的栅栏
+// 通过之后才销毁，此前提交的、仍在使用该纹理的 GPU 命令不受影响。
+// 驻留管理：记录每个纹理的显存大小与最近使用的帧，常驻显存超过预算时按最久未使用的顺序
+// 把冷纹理裁剪到不大于 gTextureTrimSize 的 MIPMAP 尾部（以更少的级别重建存储并复制），
+// 裁剪过的纹理再次被 Use 时在任务中重新解码，完成后以完整的级别替换。
+// 流式上传：解码任务同时在 CPU 上生成完整的 MIPMAP 链，纹理按完整尺寸分配存储后只立即上传不大于
+// gTextureTrimSize 的尾部级别，并把 GL_TEXTURE_BASE_LEVEL 限制在已上传的最精细级别；更精细的级别
+// 在之后的帧中从粗到细逐行上传，每帧不超过 gTextureUploadBudget 字节。只在 GL 线程中调用
+class ResourceManager
+{
+public:
+	// budgetBytes 为纹理常驻显存的预算，0 表示不限制
+	void Init(size_t budgetBytes);
+	// 等待 GPU 空闲后销毁所有纹理，仍被引用的纹理输出警告
+	void Delete();
+
+	 /********************************************************************************
+	 * @brief		批量加载纹理：未命中的文件作为任务并行解码并计算内容散列，随后在本线程上传
+	 *********************************************************************************
+	 * @param		requests 加载请求，批内的重复路径同样只解码一次
+	 * @return		与请求一一对应的句柄，每个句柄持有一个引用
+	 ********************************************************************************/
+	std::vector<TextureHandle> LoadTextures(std::span<const TextureRequest> requests);
+	TextureHandle LoadTexture(const TextureRequest& request);
+
+	// 增加一个引用，返回同一个句柄
+	TextureHandle AddRef(TextureHandle handle);
+	// 释放一个引用并清空句柄；引用归零的纹理等到下一次 CollectGarbage 的栅栏通过后销毁
+	void Release(TextureHandle& handle);
+
+	// 句柄对应的纹理对象，句柄失效或引用已归零时返回 0。裁剪或恢复后纹理对象会改变，不要跨帧保存
+	GLuint Get(TextureHandle handle) const;
+	// 同 Get，并把纹理标记为本帧使用；被裁剪过的纹理开始恢复
+	GLuint Use(TextureHandle handle);
+
+	// 每帧结束时调用：替换恢复完成的纹理，在上传预算内流式上传精细级别，超出预算时裁剪冷纹理，再回收垃圾
+	void EndFrame();
+
+	// 为本帧释放的纹理与被替换的旧纹理对象插入栅栏，销毁栅栏已通过的纹理
+	void CollectGarbage();
+
+	// 还有正在恢复或流式上传的纹理，或等待栅栏的销毁，需要继续渲染新的帧
+	bool HasPendingWork() const;
+
+	// 输出上传次数、去重命中与节省的显存
+	void LogStatistics() const;
+
+	// 输出每个纹理的尺寸、常驻级别、显存与最近使用的帧，以及常驻总量与预算
+	void LogMemoryReport() const;
+
+private:
+	// 等待上传的像素：第 0 级是解码的图像，更小的级别在解码任务中生成
+	struct Stream
+	{
+		std::shared_ptr<Image> image;
+		std::vector<std::vector<uint8_t>> mips;	// 第 1 级起
+		int nextLevel = -1;						// 下一个上传的级别，从尾部向第 0 级推进；-1 表示已全部上传
+		int nextRow = 0;						// 该级别已上传的行数
+	};
+
+	// 恢复任务的结果，任务持有它的地址，槽位在任务完成之前不会释放它
+	struct Restore
+	{
+		JobCounter done;
+		std::unique_ptr<Stream> stream;
+	};
+
+	struct Slot
+	{
+		Texture texture;
+		uint32_t generation = 1;
+		uint32_t refs = 0;
+		bool live = false;						// 纹理已创建且尚未销毁（包括等待栅栏）
+		uint64_t contentKey = 0;
+		size_t bytes = 0;						// 当前常驻级别的显存
+		std::vector<std::string> pathKeys;		// 指向本槽位的路径键，归零时从索引中移除
+		TextureRequest source;					// 第一次加载的请求，恢复时重新解码
+		int width = 0;							// 完整纹理的尺寸与级别数
+		int height = 0;
+		int levels = 0;
+		int trimmedLevels = 0;					// 被裁剪掉的顶层级别数
+		uint32_t lastUsed = 0;					// 最近一次 Use 的帧序号
+		std::unique_ptr<Restore> restore;		// 正在恢复
+		bool restoreFailed = false;				// 恢复时解码失败，保持裁剪后的状态，不再重试
+		std::unique_ptr<Stream> stream;			// 正在流式上传
+	};
+
+	struct PendingRelease
+	{
+		GLsync fence;
+		std::vector<uint32_t> slots;
+		std::vector<GLuint> textures;			// 裁剪或恢复时被替换的旧纹理对象
+	};
+
+	static std::string PathKey(const TextureRequest& request);
+	static size_t TextureBytes(GLenum iformat, int width, int height, int firstLevel, int levels);
+	// 边长不大于 gTextureTrimSize 的第一个级别，至少保留最小的一级
+	static int TailLevel(int width, int height, int levels);
+	// 在任务中调用：解码并生成 levels 级 MIPMAP 链（0 表示完整的链）
+	static std::unique_ptr<Stream> DecodeStream(const TextureRequest& request, int levels);
+	uint32_t AllocateSlot();
+	void Destroy(uint32_t index);
+	void SetTexture(Slot& slot, const Texture& texture, int trimmedLevels);
+	void Trim(Slot& slot);
+	void EnforceBudget();
+	void StartRestore(Slot& slot);
+	void FinishRestores();
+	// 从 stream 当前的级别起上传不超过 budget 字节的行，返回实际上传的字节数；级别完成后降低基础级别
+	size_t UploadRows(Slot& slot, size_t budget);
+	void StreamUploads();
+
+	std::vector<Slot> mSlots;
+	std::vector<uint32_t> mFreeSlots;
+	std::unordered_map<std::string, uint32_t> mByPath;		// 规范化路径与格式 -> 槽位
+	std::unordered_map<uint64_t, uint32_t> mByContent;		// 像素内容与格式的散列 -> 槽位
+	std::vector<uint32_t> mReleased;						// 本帧引用归零、尚未插入栅栏的槽位
+	std::vector<GLuint> mRetired;							// 本帧被替换、尚未插入栅栏的纹理对象
+	std::vector<PendingRelease> mPending;					// 按插入顺序排列，栅栏也按顺序通过
+
+	size_t mUploads = 0;
+	size_t mPathHits = 0;
+	size_t mContentHits = 0;
+	size_t mUploadedBytes = 0;
+	size_t mSavedBytes = 0;
+	size_t mDestroyed = 0;
+
+	size_t mBudget = 0;
+	size_t mResidentBytes = 0;		// 所有存活纹理当前常驻级别的显存总量
+	uint32_t mFrame = 0;
+	int mRestoring = 0;
+	int mStreaming = 0;
+	size_t mStreamedBytes = 0;
+	size_t mTrims = 0;
+	size_t mRestores = 0;
+	bool mOverBudget = false;		// 已经输出过无法回到预算内的警告
+};
+
+#endif // !__RESOURCEMANAGER_H__
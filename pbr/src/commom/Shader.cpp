@@ -1,13 +1,101 @@
 #include "Shader.h"
 #include <memory>
 #include <map>
+#include <format>
+#include <algorithm>
+#include <cstring>
 #include <vector>
+#include <chrono>
 #include <fstream>
 #include <sstream>
+#include <filesystem>
 #include "Log.h"
 #include "Path.h"
+#include "FrameArena.h"
+#include "Utils.h"
 
-GLuint Shader::LinkProgram(std::initializer_list<std::string> shaderFiles)
+namespace {
+	const char* const ShaderPath = "shaders\\glsl\\";
+	const char* const SpirvPath = "shaders\\spirv\\";
+	const char* const CachePath = "shaders\\cache\\";
+	const uint32_t CacheMagic = 0x31425250;		// "PRB1"
+
+	// ƻļͷصĶ
+	struct ProgramBinaryHeader
+	{
+		uint32_t magic;
+		GLenum format;			// صĶƸʽ
+		uint64_t key;			// Դ + GL_RENDERER + GL_VERSION Ĺϣ
+		float compileMs;		// ɻʱõʱ
+		uint32_t size;			// ݵֽ
+	};
+
+	// ׶εĻͳ
+	int gCacheHits = 0;
+	int gCacheMisses = 0;
+	float gSavedMs = 0.0f;
+
+	// Ϊػĺ꼰 constant_idɫе layout(constant_id) һһӦ
+	// к궼ڴ˱ʱʹ SPIR-V ģ飬˵ GLSL Դ
+	const std::map<std::string, GLuint> SpecConstantIds =
+	{
+		{"NUM_SAMPLES",       0},
+		{"NUM_LIGHTS",        1},
+		{"GROUP_SIZE_X",      2},
+		{"GROUP_SIZE_Y",      3},
+		{"ENABLE_IBL",        4},
+		{"ENABLE_NORMAL_MAP", 5},
+		{"VERTEX_PULLING",    6},
+	};
+
+	// أɫļ޸ʱ䣬ԼļС
+	std::map<std::string, std::filesystem::file_time_type> gFileTimes;
+	const float HotReloadIntervalMs = 250.0f;
+
+	float ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+std::unordered_map<std::string, GLuint> Shader::mVariants;
+std::unordered_map<std::string, Shader::PendingProgram> Shader::mPrefetched;
+std::vector<Shader::WatchedProgram> Shader::mWatched;
+
+GLuint Shader::LinkProgram(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines)
+{
+	// ȡǰύĳ򣬷ύ
+	PendingProgram pending;
+	auto it = mPrefetched.find(VariantKey(shaderFiles, defines));
+	if (it != mPrefetched.end())
+	{
+		pending = std::move(it->second);
+		mPrefetched.erase(it);
+	}
+	else
+	{
+		pending = SubmitProgram(shaderFiles, defines, true);
+	}
+
+	std::string error;
+	GLuint program = FinishProgram(pending, error);
+	if (!program)
+	{
+		LOG_EXCEPTION(error);
+	}
+	return program;
+}
+
+void Shader::PrefetchProgram(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines)
+{
+	const std::string key = VariantKey(shaderFiles, defines);
+	if (mPrefetched.count(key) == 0 && mVariants.count(key) == 0)
+	{
+		mPrefetched.emplace(key, SubmitProgram(shaderFiles, defines, true));
+	}
+}
+
+Shader::PendingProgram Shader::SubmitProgram(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines, bool allowSpirv)
 {
 	// ɫļӳ
 	static std::map<std::string, GLenum> shaderType =
@@ -20,68 +108,418 @@ GLuint Shader::LinkProgram(std::initializer_list<std::string> shaderFiles)
 		{"tese",GL_TESS_EVALUATION_SHADER}	// ɫTessellation Evaluation Shader
 	};
 
-	std::vector<GLuint> shaders;
-	shaders.reserve(shaderFiles.size());
+	// ֧κγƸʽʱʹû
+	static const bool binaryCacheSupported = []() {
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		return numFormats > 0;
+	}();
+
+	// ʹֵ֧֮߳ıں̨н
+	static const bool parallelCompileSupported = []() {
+		if (GLAD_GL_KHR_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		}
+		return GLAD_GL_KHR_parallel_shader_compile != 0;
+	}();
+
+	PendingProgram pending;
+	pending.start = std::chrono::high_resolution_clock::now();
+
+	// н׶ζ߱ SPIR-V ģ顢к궼ӳΪػʱ GLSL ǰ
+	bool useSpirv = allowSpirv && GLAD_GL_ARB_gl_spirv != 0;
+	for (const auto& [name, value] : defines)
+	{
+		useSpirv = useSpirv && SpecConstantIds.count(name) > 0;
+	}
+	for (const std::string& file : shaderFiles)
+	{
+		useSpirv = useSpirv && std::filesystem::exists(SpirvPath + file + ".spv");
+	}
+
+	// ȶȡȫԴ룬չԴ롢ʶͬ󻺴ԶʧЧ
+	std::vector<std::string> sources;
+	sources.reserve(shaderFiles.size());
+	std::string cacheName;
+	uint64_t key = Hash(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	key = Hash(reinterpret_cast<const char*>(glGetString(GL_VERSION)), key);
+	for (const std::string& file : shaderFiles)
+	{
+		if (useSpirv)
+		{
+			const std::vector<char> binary = File::ReadBinary(SpirvPath + file + ".spv");
+			sources.emplace_back(binary.begin(), binary.end());
+		}
+		else
+		{
+			sources.push_back(PreprocessShader(file, defines));
+		}
+		key = Hash(file, key);
+		key = Hash(sources.back(), key);
+		cacheName += (cacheName.empty() ? "" : "+") + file;
+	}
+	if (defines.size() > 0)
+	{
+		// ͬһļĲͬʹøԵĻļ
+		const uint64_t variant = Hash(VariantKey(shaderFiles, defines));
+		key = variant ^ key;
+		cacheName += std::format("@{:08x}", static_cast<uint32_t>(variant));
+	}
+	pending.cacheFile = binaryCacheSupported ? CachePath + cacheName + ".bin" : "";
+	pending.key = key;
+
+	if (binaryCacheSupported)
+	{
+		float compileMs = 0.0f;
+		pending.program = LoadProgramBinary(pending.cacheFile, key, compileMs);
+		if (pending.program)
+		{
+			const float loadMs = ElapsedMs(pending.start);
+			++gCacheHits;
+			gSavedMs += std::max(compileMs - loadMs, 0.0f);
+			LOG_INFO(std::format("Loaded program binary: {} ({:.2f} ms, compile {:.2f} ms)", cacheName, loadMs, compileMs));
+			pending.fromCache = true;
+			return pending;
+		}
+		++gCacheMisses;
+	}
+
 	std::string ext = "";
-	GLuint shaderId;
-	GLuint program = glCreateProgram();
+	pending.program = glCreateProgram();
+	size_t index = 0;
 	for (std::string file : shaderFiles)
 	{
 		ext = file.substr(file.find_last_of(".") + 1);
-		file = "shaders\\glsl\\" + file;
+		file = (useSpirv ? SpirvPath : ShaderPath) + file;
 		//file = PATH + file;
 		//LOG_ASSERT(!shaderType[ext], "ɫļļͲ֧\t"+file);
 		LOG_ASSERT(!shaderType[ext], "Wrong compilation shader file, file type not supported:\t" + file);
-		shaderId = CompileShader(file, shaderType[ext]);
-		glAttachShader(program, shaderId);
-		shaders.push_back(shaderId);
+		if (useSpirv)
+		{
+			file += ".spv";
+			pending.shaders.push_back(CompileSpirvShader(file, sources[index++], shaderType[ext], defines));
+		}
+		else
+		{
+			pending.shaders.push_back(CompileShader(file, sources[index++], shaderType[ext]));
+		}
+		pending.files.push_back(file);
+		glAttachShader(pending.program, pending.shaders.back());
 	}
-	glLinkProgram(program);
-	for (GLuint shader : shaders)
+	if (binaryCacheSupported)
 	{
-		glDetachShader(program, shader);
-		glDeleteShader(shader);
+		glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(pending.program);
+	pending.submitMs = ElapsedMs(pending.start);
+	if (parallelCompileSupported)
+	{
+		LOG_INFO("Submitted program for parallel compilation: " + cacheName);
+	}
+	return pending;
+}
+
+bool Shader::IsProgramComplete(const PendingProgram& pending)
+{
+	// û KHR_parallel_shader_compile ʱͬģFinishProgram 
+	if (pending.fromCache || !GLAD_GL_KHR_parallel_shader_compile)
+	{
+		return true;
 	}
+	GLint completed = GL_FALSE;
+	glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed == GL_TRUE;
+}
 
+GLuint Shader::FinishProgram(PendingProgram& pending, std::string& error)
+{
+	if (pending.fromCache)
+	{
+		return pending.program;
+	}
+
+	// ѯ״̬ȴı߳
+	const auto waitStart = std::chrono::high_resolution_clock::now();
 	GLint status;
-	glGetProgramiv(program, GL_LINK_STATUS, &status);
-	if (status == GL_TRUE) 
+	glGetProgramiv(pending.program, GL_LINK_STATUS, &status);
+	// ʱֻύȴӽʱ䣺ǰύصĳڼ֮֡ȡأύڵʱ
+	const float compileMs = pending.submitMs + ElapsedMs(waitStart);
+#if _DEBUG
+	// ֤ϴʱûаʵʵȾ״̬ڵ԰汾ִ
+	if (status == GL_TRUE)
 	{
-		glValidateProgram(program);
-		glGetProgramiv(program, GL_VALIDATE_STATUS, &status);
+		glValidateProgram(pending.program);
+		glGetProgramiv(pending.program, GL_VALIDATE_STATUS, &status);
 	}
-	if (status != GL_TRUE) 
+#endif
+	if (status != GL_TRUE)
 	{
-		GLsizei infoLogSize;
-		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogSize);
-		std::unique_ptr<GLchar[]> infoLog(new GLchar[infoLogSize]);
-		glGetProgramInfoLog(program, infoLogSize, nullptr, infoLog.get());
-		LOG_EXCEPTION(std::string("Program link failed\n") + infoLog.get());
+		// ȱʧܵɫǳ־
+		for (size_t i = 0; i < pending.shaders.size() && error.empty(); ++i)
+		{
+			glGetShaderiv(pending.shaders[i], GL_COMPILE_STATUS, &status);
+			if (status != GL_TRUE)
+			{
+				GLsizei infoLogSize;
+				glGetShaderiv(pending.shaders[i], GL_INFO_LOG_LENGTH, &infoLogSize);
+				std::unique_ptr<GLchar[]> infoLog(new GLchar[infoLogSize]);
+				glGetShaderInfoLog(pending.shaders[i], infoLogSize, nullptr, infoLog.get());
+				error = std::string("Shader compilation failed: ") + pending.files[i] + "\n" + infoLog.get();
+			}
+		}
+		if (error.empty())
+		{
+			GLsizei infoLogSize;
+			glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &infoLogSize);
+			std::unique_ptr<GLchar[]> infoLog(new GLchar[infoLogSize]);
+			glGetProgramInfoLog(pending.program, infoLogSize, nullptr, infoLog.get());
+			error = std::string("Program link failed\n") + infoLog.get();
+		}
 	}
+
+	for (GLuint shader : pending.shaders)
+	{
+		glDetachShader(pending.program, shader);
+		glDeleteShader(shader);
+	}
+	pending.shaders.clear();
+
+	if (!error.empty())
+	{
+		glDeleteProgram(pending.program);
+		return 0;
+	}
+	if (!pending.cacheFile.empty())
+	{
+		SaveProgramBinary(pending.program, pending.cacheFile, pending.key, compileMs);
+	}
+	return pending.program;
+}
+
+GLuint Shader::GetProgramVariant(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines)
+{
+	const std::string key = VariantKey(shaderFiles, defines);
+	auto it = mVariants.find(key);
+	if (it != mVariants.end())
+	{
+		return it->second;
+	}
+	const GLuint program = LinkProgram(shaderFiles, defines);
+	// unordered_map ԪصַڲԪغ󱣳ֲ䣬ֱӽ滻
+	it = mVariants.emplace(key, program).first;
+	WatchProgram(it->second, shaderFiles, defines);
 	return program;
 }
 
-GLuint Shader::CompileShader(const std::string& filename, GLenum type)
+void Shader::DeleteProgramVariants()
+{
+	for (auto& [key, program] : mVariants)
+	{
+		std::erase_if(mWatched, [&](WatchedProgram& watched) {
+			if (watched.program != &program) return false;
+			DiscardProgram(watched.reload);
+			return true;
+		});
+		glDeleteProgram(program);
+	}
+	mVariants.clear();
+
+	// ǰύδȡصĳ
+	for (auto& [key, pending] : mPrefetched)
+	{
+		DiscardProgram(pending);
+	}
+	mPrefetched.clear();
+}
+
+void Shader::WatchProgram(GLuint& program, const std::vector<std::string>& shaderFiles, const ShaderDefines& defines)
+{
+	WatchedProgram watched;
+	watched.program = &program;
+	watched.files = shaderFiles;
+	watched.defines = defines;
+	SetDependencies(watched);
+	// ¼ǰ޸ʱ䣬֮޸ĲŻᴥ±
+	for (size_t i = 0; i < watched.dependencies.size(); ++i)
+	{
+		std::error_code ec;
+		const auto time = std::filesystem::last_write_time(watched.dependencyPaths[i], ec);
+		if (!ec)
+		{
+			gFileTimes.emplace(watched.dependencies[i], time);
+		}
+	}
+	mWatched.push_back(std::move(watched));
+}
+
+void Shader::UnwatchPrograms()
+{
+	for (WatchedProgram& watched : mWatched)
+	{
+		DiscardProgram(watched.reload);
+	}
+	mWatched.clear();
+}
+
+bool Shader::UpdateHotReload()
+{
+	// 滻Ѿɺ̨ĳδɵĳ򲻲ѯ״̬˲ǰ֡
+	bool replaced = false;
+	for (WatchedProgram& watched : mWatched)
+	{
+		if (!watched.reload.program || !IsProgramComplete(watched.reload))
+		{
+			continue;
+		}
+		std::string error;
+		const auto start = watched.reload.start;
+		const GLuint program = FinishProgram(watched.reload, error);
+		watched.reload = PendingProgram();
+		if (!program)
+		{
+			// ʧʱɳԴٴδ±
+			LOG_WARN("Hot reload failed, keeping previous program\n" + error);
+			continue;
+		}
+		glDeleteProgram(*watched.program);
+		*watched.program = program;
+		try
+		{
+			SetDependencies(watched);
+		}
+		catch (const std::exception& e)
+		{
+			// ύ֮ļֱɾԭбļָܴ±
+			LOG_WARN(std::string("Hot reload could not update dependencies, keeping previous list\n") + e.what());
+		}
+		replaced = true;
+		LOG_INFO(std::format("Hot reloaded program: {} ({:.2f} ms)", watched.files.front(), ElapsedMs(start)));
+	}
+
+	// ѯļ޸ʱҪϵͳãƼƵ
+	static auto lastCheck = std::chrono::high_resolution_clock::now();
+	if (ElapsedMs(lastCheck) < HotReloadIntervalMs)
+	{
+		return replaced;
+	}
+	lastCheck = std::chrono::high_resolution_clock::now();
+
+	// Ⱦ߳ѯ·Ԥƴӣ޸б֡Уͨö
+	FrameVector<const std::string*> modified;
+	for (const WatchedProgram& watched : mWatched)
+	{
+		for (size_t i = 0; i < watched.dependencies.size(); ++i)
+		{
+			std::error_code ec;
+			const auto time = std::filesystem::last_write_time(watched.dependencyPaths[i], ec);
+			if (ec)
+			{
+				continue;	// ༭ʱļʱ
+			}
+			const std::string& file = watched.dependencies[i];
+			const auto found = gFileTimes.find(file);
+			if (found == gFileTimes.end())
+			{
+				gFileTimes.emplace(file, time);
+			}
+			else if (found->second != time)
+			{
+				found->second = time;
+				modified.push_back(&file);
+			}
+		}
+	}
+
+	for (WatchedProgram& watched : mWatched)
+	{
+		const bool affected = std::any_of(modified.begin(), modified.end(), [&](const std::string* file) {
+			return std::find(watched.dependencies.begin(), watched.dependencies.end(), *file) != watched.dependencies.end();
+		});
+		if (!affected)
+		{
+			continue;
+		}
+		// һ޸ĵı뻹ûʱֱӶʹµԴύ
+		//  SPIR-V ģ޸ĺԴɣʹ GLSL Դ
+		DiscardProgram(watched.reload);
+		try
+		{
+			watched.reload = SubmitProgram(watched.files, watched.defines, false);
+		}
+		catch (const std::exception& e)
+		{
+			watched.reload = PendingProgram();
+			LOG_WARN(std::string("Hot reload failed, keeping previous program\n") + e.what());
+		}
+	}
+	return replaced;
+}
+
+void Shader::DiscardProgram(PendingProgram& pending)
+{
+	for (GLuint shader : pending.shaders)
+	{
+		glDeleteShader(shader);
+	}
+	if (pending.program)
+	{
+		glDeleteProgram(pending.program);
+	}
+	pending = PendingProgram();
+}
+
+void Shader::LogCacheStatistics()
+{
+	LOG_INFO(std::format("Program binary cache: {} hits, {} misses, saved {:.2f} ms", gCacheHits, gCacheMisses, gSavedMs));
+}
+
+GLuint Shader::CompileShader(const std::string& filename, const std::string& src, GLenum type)
 {
-	const std::string src = ReadShaderFile(filename);
 	LOG_ASSERT(src.empty(), "Read shader file failed:\t" + filename);
 	LOG_INFO("Compiling GLSL shader: "+filename);
 	const GLchar* srcBufferPtr = src.c_str();
 
 	GLuint shader = glCreateShader(type);
 	glShaderSource(shader, 1, &srcBufferPtr, nullptr);
+	// ѯ״̬ȴɱ룬ͳһ FinishProgram м
 	glCompileShader(shader);
+	return shader;
+}
 
-	GLint status;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-	if (status != GL_TRUE) 
+GLuint Shader::CompileSpirvShader(const std::string& filename, const std::string& binary, GLenum type, const ShaderDefines& defines)
+{
+	LOG_ASSERT(binary.size() < 5 * sizeof(uint32_t) || binary.size() % sizeof(uint32_t) != 0, "Invalid SPIR-V module:\t" + filename);
+	LOG_INFO("Loading SPIR-V shader: " + filename);
+
+	// ֻģʵػ glSpecializeShader ʧܡ
+	// ɨ OpDecorate <id> SpecId <n> 5 ֵļͷÿֵָĸ 16 λΪ
+	std::vector<uint32_t> words(binary.size() / sizeof(uint32_t));
+	std::memcpy(words.data(), binary.data(), binary.size());
+	std::vector<GLuint> declared;
+	for (size_t i = 5; i < words.size(); i += std::max(words[i] >> 16, 1u))
+	{
+		const uint32_t opDecorate = 71, decorationSpecId = 1;
+		if ((words[i] & 0xFFFF) == opDecorate && (words[i] >> 16) == 4 && i + 3 < words.size() && words[i + 2] == decorationSpecId)
+		{
+			declared.push_back(words[i + 3]);
+		}
+	}
+	std::vector<GLuint> indices, values;
+	for (const auto& [name, value] : defines)
 	{
-		GLsizei infoLogSize;
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLogSize);
-		std::unique_ptr<GLchar[]> infoLog(new GLchar[infoLogSize]);
-		glGetShaderInfoLog(shader, infoLogSize, nullptr, infoLog.get());
-		LOG_EXCEPTION(std::string("Shader compilation failed: ") + filename + "\n" + infoLog.get());
+		const GLuint id = SpecConstantIds.at(name);
+		if (std::find(declared.begin(), declared.end(), id) != declared.end())
+		{
+			indices.push_back(id);
+			values.push_back(static_cast<GLuint>(value));
+		}
 	}
+
+	GLuint shader = glCreateShader(type);
+	glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, binary.data(), static_cast<GLsizei>(binary.size()));
+	// ػ GLSL һ FinishProgram м
+	glSpecializeShaderARB(shader, "main", static_cast<GLuint>(indices.size()), indices.data(), values.data());
 	return shader;
 }
 
@@ -95,3 +533,159 @@ std::string Shader::ReadShaderFile(const std::string& filename)
 	return buffer.str();
 	return std::string();
 }
+
+std::string Shader::PreprocessShader(const std::string& filename, const ShaderDefines& defines)
+{
+	std::vector<std::string> included;
+	const std::string src = ResolveIncludes(ReadShaderFile(ShaderPath + filename), included);
+
+	// λ #version ֮#line ֤кԴļһ
+	const size_t versionEnd = src.find('\n', src.find("#version")) + 1;
+	std::string preamble;
+	for (const auto& [name, value] : defines)
+	{
+		preamble += std::format("#define {} {}\n", name, value);
+	}
+	preamble += "#line 2\n";
+	return src.substr(0, versionEnd) + preamble + src.substr(versionEnd);
+}
+
+std::string Shader::ResolveIncludes(const std::string& src, std::vector<std::string>& included)
+{
+	// չ #include "file" shaders/glslͬһļֻչһΡ
+	//  SPIR-V  glslangValidator ͨ GL_GOOGLE_include_directive ͬĹ
+	std::istringstream stream{ src };
+	std::string result, line;
+	int lineNumber = 0;
+	while (std::getline(stream, line))
+	{
+		++lineNumber;
+		const size_t directive = line.find("#include");
+		if (directive == std::string::npos || line.find_first_not_of(" \t") != directive)
+		{
+			result += line + "\n";
+			continue;
+		}
+		const size_t begin = line.find('"', directive) + 1;
+		const size_t end = line.find('"', begin);
+		LOG_ASSERT(begin == 0 || end == std::string::npos, "Malformed #include directive: " + line);
+		const std::string includeFile = line.substr(begin, end - begin);
+		if (std::find(included.begin(), included.end(), includeFile) == included.end())
+		{
+			included.push_back(includeFile);
+			result += "#line 1\n";
+			result += ResolveIncludes(ReadShaderFile(ShaderPath + includeFile), included);
+		}
+		result += std::format("#line {}\n", lineNumber + 1);
+	}
+	return result;
+}
+
+void Shader::SetDependencies(WatchedProgram& watched)
+{
+	watched.dependencies = ShaderDependencies(watched.files);
+	watched.dependencyPaths.clear();
+	for (const std::string& file : watched.dependencies)
+	{
+		watched.dependencyPaths.emplace_back(ShaderPath + file);
+	}
+}
+
+std::vector<std::string> Shader::ShaderDependencies(const std::vector<std::string>& shaderFiles)
+{
+	std::vector<std::string> dependencies = shaderFiles;
+	for (const std::string& file : shaderFiles)
+	{
+		std::vector<std::string> included;
+		ResolveIncludes(ReadShaderFile(ShaderPath + file), included);
+		for (const std::string& include : included)
+		{
+			if (std::find(dependencies.begin(), dependencies.end(), include) == dependencies.end())
+			{
+				dependencies.push_back(include);
+			}
+		}
+	}
+	return dependencies;
+}
+
+std::string Shader::VariantKey(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines)
+{
+	std::string key;
+	for (const std::string& file : shaderFiles)
+	{
+		key += file + "+";
+	}
+	for (const auto& [name, value] : defines)
+	{
+		key += std::format("|{}={}", name, value);
+	}
+	return key;
+}
+
+GLuint Shader::LoadProgramBinary(const std::string& cacheFile, uint64_t key, float& compileMs)
+{
+	// 治ﲻʹ LOG_ASSERT
+	std::ifstream file{ cacheFile, std::ios::binary };
+	if (!file.is_open()) return 0;
+
+	ProgramBinaryHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != CacheMagic || header.key != key)
+	{
+		return 0;
+	}
+	std::vector<char> binary(header.size);
+	if (!file.read(binary.data(), header.size)) return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.size));
+
+	// ʱܾɵĶƣʱ˵±
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		LOG_WARN("Program binary rejected by driver, recompiling: " + cacheFile);
+		glDeleteProgram(program);
+		return 0;
+	}
+	compileMs = header.compileMs;
+	return program;
+}
+
+void Shader::SaveProgramBinary(GLuint program, const std::string& cacheFile, uint64_t key, float compileMs)
+{
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0) return;
+
+	ProgramBinaryHeader header;
+	header.magic = CacheMagic;
+	header.key = key;
+	header.compileMs = compileMs;
+	std::vector<char> binary(size);
+	glGetProgramBinary(program, size, nullptr, &header.format, binary.data());
+	header.size = static_cast<uint32_t>(size);
+
+	std::error_code error;
+	std::filesystem::create_directories(CachePath, error);
+	std::ofstream file{ cacheFile, std::ios::binary | std::ios::trunc };
+	if (!file.is_open())
+	{
+		LOG_WARN("Could not write program binary cache: " + cacheFile);
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(binary.data(), size);
+}
+
+uint64_t Shader::Hash(const std::string& data, uint64_t hash)
+{
+	// FNV-1a 64 λϣ
+	for (unsigned char c : data)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -1,17 +1,150 @@
 #pragma once
 #ifndef __SHADER_H__
 #define __SHADER_H__
-#include <initializer_list>
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <glad/glad.h>
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include <filesystem>
+
+// 着色器变体的宏定义集合（宏名 -> 值）。
+// GLSL 路径以 #define 的形式注入到 #version 之后；SPIR-V 路径映射为同名的特化常量
+using ShaderDefines = std::map<std::string, int>;
+
 class Shader
 {
 public:
-	static GLuint LinkProgram(std::initializer_list<std::string> shaderFiles);
+	 /********************************************************************************
+	 * @brief		链接着色器程序，依次尝试程序二进制缓存、离线 SPIR-V 模块和 GLSL 源码
+	 *********************************************************************************
+	 * @param		shaderFiles 着色器文件名（位于 shaders/glsl）
+	 * @param		defines 变体宏定义
+	 * @return		链接好的程序对象，由调用者负责删除
+	 ********************************************************************************/
+	static GLuint LinkProgram(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines = {});
+
+	 /********************************************************************************
+	 * @brief		提前提交程序的编译链接而不等待结果，驱动的编译线程在加载其他资源时并行工作。
+	 *				之后以相同参数调用 LinkProgram 或 GetProgramVariant 时取回该程序
+	 *********************************************************************************
+	 * @param		shaderFiles 着色器文件名（位于 shaders/glsl）
+	 * @param		defines 变体宏定义
+	 ********************************************************************************/
+	static void PrefetchProgram(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines = {});
+
+	 /********************************************************************************
+	 * @brief		按变体键获取程序，首次请求时链接并缓存
+	 *********************************************************************************
+	 * @param		shaderFiles 着色器文件名（位于 shaders/glsl）
+	 * @param		defines 变体宏定义
+	 * @return		缓存中的程序对象，由 DeleteProgramVariants 统一删除
+	 ********************************************************************************/
+	static GLuint GetProgramVariant(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines);
+	static void DeleteProgramVariants();
+
+	 /********************************************************************************
+	 * @brief		监视程序依赖的着色器文件（含 #include），文件修改后在后台重新编译并替换
+	 *********************************************************************************
+	 * @param		program 程序对象的引用，重新链接成功后被替换为新程序
+	 * @param		shaderFiles 着色器文件名（位于 shaders/glsl）
+	 * @param		defines 变体宏定义
+	 ********************************************************************************/
+	static void WatchProgram(GLuint& program, const std::vector<std::string>& shaderFiles, const ShaderDefines& defines = {});
+	static void UnwatchPrograms();
+
+	 /********************************************************************************
+	 * @brief		每帧调用：检查被监视的文件，提交重新编译，并替换已完成链接的程序
+	 *********************************************************************************
+	 * @return		本次调用中是否有程序被替换
+	 ********************************************************************************/
+	static bool UpdateHotReload();
+
+	// 输出程序二进制缓存的命中情况以及节省的编译时间
+	static void LogCacheStatistics();
 
 private:
-	static GLuint CompileShader(const std::string& filename, GLenum type);
+	// 已提交编译链接、尚未检查结果的程序
+	struct PendingProgram
+	{
+		GLuint program = 0;
+		std::vector<GLuint> shaders;		// 链接完成前保留，失败时用于取得编译日志
+		std::vector<std::string> files;
+		std::string cacheFile;
+		uint64_t key = 0;
+		bool fromCache = false;				// 由程序二进制缓存直接加载，已经链接完成
+		std::chrono::high_resolution_clock::time_point start;
+		float submitMs = 0.0f;				// 读取源码到提交链接所用的时间，没有并行编译时包括驱动的编译
+	};
+
+	// 热重载监视项
+	struct WatchedProgram
+	{
+		GLuint* program;
+		std::vector<std::string> files;
+		ShaderDefines defines;
+		std::vector<std::string> dependencies;	// 着色器文件及其展开的 #include 文件
+		std::vector<std::filesystem::path> dependencyPaths;	// 依赖文件的完整路径，轮询修改时间时不再拼接字符串
+		PendingProgram reload;					// 正在后台重新编译的程序，program 为 0 表示没有
+	};
+
+	 /********************************************************************************
+	 * @brief		提交编译与链接，不查询任何状态，因此不会等待驱动完成
+	 *********************************************************************************
+	 * @param		shaderFiles 着色器文件名（位于 shaders/glsl）
+	 * @param		defines 变体宏定义
+	 * @param		allowSpirv 是否允许使用离线 SPIR-V 模块，热重载时源码比模块新，必须为 false
+	 * @return		提交的程序，命中程序二进制缓存时已经链接完成
+	 ********************************************************************************/
+	static PendingProgram SubmitProgram(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines, bool allowSpirv);
+	static bool IsProgramComplete(const PendingProgram& pending);
+
+	 /********************************************************************************
+	 * @brief		检查编译与链接结果，成功时写入程序二进制缓存，失败时删除程序
+	 *********************************************************************************
+	 * @param		pending 提交的程序，驱动尚未完成时会阻塞等待
+	 * @param		error 输出：失败时的编译或链接日志
+	 * @return		链接好的程序对象，失败时为 0
+	 ********************************************************************************/
+	static GLuint FinishProgram(PendingProgram& pending, std::string& error);
+	static void DiscardProgram(PendingProgram& pending);
+
+	static GLuint CompileShader(const std::string& filename, const std::string& src, GLenum type);
+	static GLuint CompileSpirvShader(const std::string& filename, const std::string& binary, GLenum type, const ShaderDefines& defines);
 	static std::string ReadShaderFile(const std::string& filename);
+
+	 /********************************************************************************
+	 * @brief		展开 #include "file" 并在 #version 之后插入变体宏定义
+	 *********************************************************************************
+	 * @param		filename 着色器文件名（位于 shaders/glsl）
+	 * @param		defines 变体宏定义
+	 * @return		可直接交给驱动编译的完整源码
+	 ********************************************************************************/
+	static std::string PreprocessShader(const std::string& filename, const ShaderDefines& defines);
+	static std::string ResolveIncludes(const std::string& src, std::vector<std::string>& included);
+	static std::string VariantKey(const std::vector<std::string>& shaderFiles, const ShaderDefines& defines);
+	static std::vector<std::string> ShaderDependencies(const std::vector<std::string>& shaderFiles);
+	// 更新监视项的依赖文件及其完整路径
+	static void SetDependencies(WatchedProgram& watched);
+
+	 /********************************************************************************
+	 * @brief		从磁盘缓存加载程序二进制，驱动拒绝或缓存失效时返回 0
+	 *********************************************************************************
+	 * @param		cacheFile 缓存文件路径
+	 * @param		key 由着色器源码和 GL_RENDERER/GL_VERSION 计算出的哈希
+	 * @param		compileMs 输出：生成该缓存时记录的编译链接耗时
+	 * @return		链接好的程序对象或 0
+	 ********************************************************************************/
+	static GLuint LoadProgramBinary(const std::string& cacheFile, uint64_t key, float& compileMs);
+	static void SaveProgramBinary(GLuint program, const std::string& cacheFile, uint64_t key, float compileMs);
+	static uint64_t Hash(const std::string& data, uint64_t hash = 14695981039346656037ull);
+
+private:
+	static std::unordered_map<std::string, GLuint> mVariants;		// 变体键 -> 程序
+	static std::unordered_map<std::string, PendingProgram> mPrefetched;	// 变体键 -> 提前提交的程序
+	static std::vector<WatchedProgram> mWatched;					// 热重载监视的程序
 };
 
 #endif // !__SHADER_H__
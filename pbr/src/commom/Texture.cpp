@@ -22,6 +22,11 @@ Texture::Texture(std::string filename, int channel, GLenum format, GLenum iforma
 	Init(filename, channel, format, iformat, level);
 }
 
+Texture::Texture(const Image& image, GLenum format, GLenum iformat, int level)
+{
+	Init(image, format, iformat, level);
+}
+
 void Texture::Init(GLenum target, int width, int height, GLenum iformat, int level)
 {
 	mWidth = width;
@@ -34,21 +39,26 @@ void Texture::Init(GLenum target, int width, int height, GLenum iformat, int lev
 void Texture::Init(std::string filename, int channel, GLenum format, GLenum iformat, int level)
 {
 	std::shared_ptr<Image> image= Image::ReadFile(filename, channel);
-	mWidth = image->mWidth;
-	mHeight = image->mHeight;
+	Init(*image, format, iformat, level);
+}
+
+void Texture::Init(const Image& image, GLenum format, GLenum iformat, int level)
+{
+	mWidth = image.mWidth;
+	mHeight = image.mHeight;
 
 	// Ϊ 0Զ MIPMAP 
 	mLevel = (level == 0) ? CalMipmapLevel() : level;
 
 	CreateTexture(GL_TEXTURE_2D, iformat);
 
-	if (image->mIsHDR)
+	if (image.mIsHDR)
 	{
-		glTextureSubImage2D(mId, 0, 0, 0, mWidth, mHeight, format, GL_FLOAT, image->GetPixels<float>());
+		glTextureSubImage2D(mId, 0, 0, 0, mWidth, mHeight, format, GL_FLOAT, image.GetPixels<float>());
 	}
 	else
 	{
-		glTextureSubImage2D(mId, 0, 0, 0, mWidth, mHeight, format, GL_UNSIGNED_BYTE, image->GetPixels<unsigned char>());
+		glTextureSubImage2D(mId, 0, 0, 0, mWidth, mHeight, format, GL_UNSIGNED_BYTE, image.GetPixels<unsigned char>());
 	}
 
 	if (mLevel > 1)
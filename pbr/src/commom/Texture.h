@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 #include <string>
 
+class Image;
+
 class Texture
 {
 public:
@@ -10,8 +12,11 @@ public:
 	~Texture();
 	Texture(GLenum target, int width, int height, GLenum internalformat, int levels = 0);
 	Texture(std::string filename, int channel, GLenum format, GLenum iformat, int level = 0);
+	// image Ѿ루жȡ GL ̴߳ϴ
+	Texture(const Image& image, GLenum format, GLenum iformat, int level = 0);
 	void Init(GLenum target, int width, int height, GLenum internalformat, int levels = 0);
 	void Init(std::string filename, int channel, GLenum format, GLenum iformat, int level = 0);
+	void Init(const Image& image, GLenum format, GLenum iformat, int level = 0);
 
 	void DelTexture();
 
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef __TRIPLEBUFFER_H__
+#define __TRIPLEBUFFER_H__
+#include <atomic>
+#include <cstdint>
+
+// 单写单读的无锁快照交接：写入端与读取端各持有一个槽位（双缓冲），另有一个中间槽位用于交换。
+// 写入端写完自己的槽位后与中间槽位交换（发布），读取端有新快照时与中间槽位交换（取得）。
+// 双方都只做一次原子交换，从不等待对方；读取端总是取得最新发布的快照，中间被覆盖的快照直接丢弃。
+template<typename T>
+class TripleBuffer
+{
+public:
+	// 写入端：当前可写的槽位
+	T& Back() { return mSlots[mBack]; }
+
+	// 写入端：发布 Back() 的内容，之后 Back() 指向另一个槽位（内容为之前的某个快照）
+	void Publish()
+	{
+		const uint32_t old = mMiddle.exchange(mBack | mkFresh, std::memory_order_acq_rel);
+		mBack = old & mkIndexMask;
+	}
+
+	 /********************************************************************************
+	 * @brief		读取端：如果有新发布的快照，取得它作为 Front()
+	 *********************************************************************************
+	 * @return		Front() 是否变为新的快照
+	 ********************************************************************************/
+	bool Consume()
+	{
+		if ((mMiddle.load(std::memory_order_acquire) & mkFresh) == 0)
+		{
+			return false;
+		}
+		const uint32_t old = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+		mFront = old & mkIndexMask;
+		return true;
+	}
+
+	// 读取端：最近取得的快照，在下一次 Consume 之前不会被写入端修改
+	const T& Front() const { return mSlots[mFront]; }
+
+private:
+	static constexpr uint32_t mkIndexMask = 3;
+	static constexpr uint32_t mkFresh = 4;		// 中间槽位的内容尚未被读取端取得
+
+	T mSlots[3];
+	uint32_t mBack = 0;							// 只由写入端访问
+	std::atomic<uint32_t> mMiddle{ 1 };
+	uint32_t mFront = 2;						// 只由读取端访问
+};
+
+#endif // !__TRIPLEBUFFER_H__
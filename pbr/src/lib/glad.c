@@ -7,15 +7,18 @@
     APIs: gl=4.5
     Profile: core
     Extensions:
+        GL_ARB_gl_spirv
+        GL_ARB_pipeline_statistics_query
         GL_EXT_texture_filter_anisotropic
+        GL_KHR_parallel_shader_compile
     Loader: True
     Local files: False
     Omit khrplatform: False
 
     Commandline:
-        --profile="core" --api="gl=4.5" --generator="c" --spec="gl" --extensions="GL_EXT_texture_filter_anisotropic"
+        --profile="core" --api="gl=4.5" --generator="c" --spec="gl" --extensions="GL_ARB_gl_spirv,GL_ARB_pipeline_statistics_query,GL_EXT_texture_filter_anisotropic,GL_KHR_parallel_shader_compile"
     Online:
-        http://glad.dav1d.de/#profile=core&language=c&specification=gl&loader=on&api=gl%3D4.5&extensions=GL_EXT_texture_filter_anisotropic
+        http://glad.dav1d.de/#profile=core&language=c&specification=gl&loader=on&api=gl%3D4.5&extensions=GL_ARB_gl_spirv&extensions=GL_ARB_pipeline_statistics_query&extensions=GL_EXT_texture_filter_anisotropic&extensions=GL_KHR_parallel_shader_compile
 */
 
 #if defined(ENABLE_OPENGL)
@@ -935,6 +938,9 @@ PFNGLNAMEDFRAMEBUFFERPARAMETERIPROC glad_glNamedFramebufferParameteri;
 PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC glad_glDrawArraysInstancedBaseInstance;
 PFNGLDELETEPROGRAMPIPELINESPROC glad_glDeleteProgramPipelines;
 int GLAD_GL_EXT_texture_filter_anisotropic;
+int GLAD_GL_ARB_pipeline_statistics_query;
+int GLAD_GL_KHR_parallel_shader_compile;
+int GLAD_GL_ARB_gl_spirv;
 static void load_GL_VERSION_1_0(GLADloadproc load) {
 	if(!GLAD_GL_VERSION_1_0) return;
 	glad_glCullFace = (PFNGLCULLFACEPROC)load("glCullFace");
@@ -1687,9 +1693,22 @@ static void load_GL_VERSION_4_5(GLADloadproc load) {
 	glad_glGetnMinmax = (PFNGLGETNMINMAXPROC)load("glGetnMinmax");
 	glad_glTextureBarrier = (PFNGLTEXTUREBARRIERPROC)load("glTextureBarrier");
 }
+PFNGLSPECIALIZESHADERARBPROC glad_glSpecializeShaderARB;
+static void load_GL_ARB_gl_spirv(GLADloadproc load) {
+	if(!GLAD_GL_ARB_gl_spirv) return;
+	glad_glSpecializeShaderARB = (PFNGLSPECIALIZESHADERARBPROC)load("glSpecializeShaderARB");
+}
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+static void load_GL_KHR_parallel_shader_compile(GLADloadproc load) {
+	if(!GLAD_GL_KHR_parallel_shader_compile) return;
+	glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+}
 static int find_extensionsGL(void) {
 	if (!get_exts()) return 0;
 	GLAD_GL_EXT_texture_filter_anisotropic = has_ext("GL_EXT_texture_filter_anisotropic");
+	GLAD_GL_ARB_gl_spirv = has_ext("GL_ARB_gl_spirv");
+	GLAD_GL_KHR_parallel_shader_compile = has_ext("GL_KHR_parallel_shader_compile");
+	GLAD_GL_ARB_pipeline_statistics_query = has_ext("GL_ARB_pipeline_statistics_query");
 	free_exts();
 	return 1;
 }
@@ -1780,6 +1799,8 @@ int gladLoadGLLoader(GLADloadproc load) {
 	load_GL_VERSION_4_5(load);
 
 	if (!find_extensionsGL()) return 0;
+	load_GL_ARB_gl_spirv(load);
+	load_GL_KHR_parallel_shader_compile(load);
 	return GLVersion.major != 0 || GLVersion.minor != 0;
 }
 